@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ALIASTABLE_HH_
+#define ALIASTABLE_HH_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/** Walker’s alias method (with Vose’s construction) to draw from a discrete distribution in O(1)
+ *
+ * Each of the n columns holds a probability of keeping that column, and an alias to return otherwise.
+ * A single 64-bit random number is used per draw: the high bits select the column, the low bits decide the alias.
+ */
+class AliasTable
+{
+public:
+	AliasTable()
+		: m_threshold(), m_alias()
+	{
+	}
+
+	AliasTable(const std::vector<double> &weights)
+		: m_threshold(weights.size(), 0), m_alias(weights.size(), 0)
+	{
+		const size_t n = weights.size();
+
+		double total = 0.;
+		for (double w: weights)
+			total += w;
+
+		std::vector<double> scaled(n);
+		std::vector<size_t> small, large;
+		for (size_t i = 0; i < n; i++)
+		{
+			scaled[i] = weights[i] * n / total;
+			(scaled[i] < 1. ? small : large).push_back(i);
+		}
+
+		while (!small.empty() && !large.empty())
+		{
+			size_t s = small.back(), l = large.back();
+			small.pop_back();
+
+			set(s, scaled[s], l);
+
+			scaled[l] -= 1. - scaled[s];
+			if (scaled[l] < 1.)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+
+		// Leftovers have a probability of 1 up to rounding errors
+		for (size_t i: large)
+			set(i, 1., i);
+		for (size_t i: small)
+			set(i, 1., i);
+	}
+
+	inline
+	size_t size() const
+	{
+		return m_alias.size();
+	}
+
+	template <class URBG>
+	inline
+	size_t operator()(URBG &gen) const
+	{
+		uint64_t draw = gen();
+		size_t column = ((draw >> 32) * m_alias.size()) >> 32;
+		return static_cast<uint32_t>(draw) < m_threshold[column] ? column : m_alias[column];
+	}
+
+private:
+	/** Keep the column if the low 32 bits of the draw are below the threshold, a probability scaled to 2^32 */
+	std::vector<uint64_t> m_threshold;
+	std::vector<size_t> m_alias;
+
+	inline
+	void set(size_t column, double probability, size_t alias)
+	{
+		m_threshold[column] = probability >= 1. ? (1ULL << 32) : static_cast<uint64_t>(probability * (1ULL << 32));
+		m_alias[column] = alias;
+	}
+};
+
+#endif /* ALIASTABLE_HH_ */
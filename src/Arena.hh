@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef ARENA_HH_
+#define ARENA_HH_
+
+#include <vector>
+#include <new>
+#include <memory>
+#include <utility>
+#include <iostream>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+#include <sys/mman.h>
+
+/** Bump allocator for the objects that live for the duration of a single simulation
+ *
+ * Objects are constructed in large blocks, and are all destroyed at once by release(), which keeps the blocks for the next
+ * simulation. This removes malloc/free from the per-event path. Blocks are optionally backed by hugepages.
+ */
+class Arena
+{
+public:
+	Arena(bool hugepages = false)
+		: m_hugepages(hugepages), m_block_size(hugepages ? HUGE_BLOCK : BLOCK)
+		, m_blocks(), m_used(0), m_offset(m_block_size), m_destructors()
+	{
+	}
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	~Arena()
+	{
+		release();
+		free_blocks();
+	}
+
+	/** Choose the memory backing future blocks, releasing the current contents */
+	void use_hugepages(bool hugepages)
+	{
+		release();
+		free_blocks();
+
+		m_hugepages = hugepages;
+		m_block_size = hugepages ? HUGE_BLOCK : BLOCK;
+		m_offset = m_block_size;
+	}
+
+	/** Construct an object of type T in the arena, which owns it until the next release() */
+	template<typename T, typename... Args>
+	T *make(Args&&... args)
+	{
+		T *obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+		if (!std::is_trivially_destructible<T>::value)
+			m_destructors.push_back({obj, [] (void *ptr) { static_cast<T *>(ptr)->~T(); }});
+
+		return obj;
+	}
+
+	/** Destroy all the objects of the arena, in reverse order of construction, and rewind it */
+	void release()
+	{
+		for (auto it = m_destructors.rbegin(); it != m_destructors.rend(); ++it)
+			it->second(it->first);
+
+		m_destructors.clear();
+		m_used = 0;
+		m_offset = m_block_size;
+	}
+
+private:
+	static const size_t BLOCK = 1 << 16, HUGE_BLOCK = 1 << 21;
+
+	bool m_hugepages;
+	size_t m_block_size;
+
+	/** All allocated blocks, of which the first m_used are in use, the last one up to m_offset */
+	std::vector<void *> m_blocks;
+	size_t m_used, m_offset;
+
+	std::vector<std::pair<void *, void (*)(void *)>> m_destructors;
+
+	void *allocate(size_t size, size_t align)
+	{
+		if (size > m_block_size)
+		{
+			std::cerr << "ERROR: object of " << size << " bytes does not fit in an arena block\n";
+			std::abort();
+		}
+
+		size_t offset = (m_offset + align - 1) & ~(align - 1);
+		if (offset + size > m_block_size)
+		{
+			if (m_used == m_blocks.size())
+				m_blocks.push_back(new_block());
+			m_used++;
+			offset = 0;
+		}
+
+		m_offset = offset + size;
+		return static_cast<char *>(m_blocks[m_used - 1]) + offset;
+	}
+
+	void *new_block()
+	{
+		if (!m_hugepages)
+			return ::operator new(m_block_size);
+
+		// Prefer reserved hugepages, otherwise ask for transparent hugepages
+		void *block = mmap(nullptr, m_block_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (block == MAP_FAILED)
+		{
+			block = mmap(nullptr, m_block_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (block == MAP_FAILED)
+				throw std::bad_alloc();
+			madvise(block, m_block_size, MADV_HUGEPAGE);
+		}
+
+		return block;
+	}
+
+	void free_blocks()
+	{
+		for (void *block: m_blocks)
+			if (m_hugepages)
+				munmap(block, m_block_size);
+			else
+				::operator delete(block);
+
+		m_blocks.clear();
+	}
+};
+
+#endif /* ARENA_HH_ */
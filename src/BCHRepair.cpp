@@ -56,21 +56,24 @@ BCHRepair::BCHRepair(std::string name, int n_correct, int n_detect, uint64_t dev
 failures_t BCHRepair::repair(FaultDomain *fd)
 {
 	GroupDomain_dimm *dd = dynamic_cast<GroupDomain_dimm *>(fd);
-	auto predicate = [this](FaultIntersection &error) { return error.bit_count_sum(m_word_mask) > m_n_correct; };
+	auto predicate = [this](auto &error) { return error.bit_count_sum(m_word_mask) > m_n_correct; };
 
-	std::list<FaultIntersection>& failures = dd->intersecting_ranges(m_word_bits, predicate);
+	// each chip contributes at most popcount(m_word_mask) + 1 wrong bits to the sum
+	const unsigned min_chips = m_n_correct / (__builtin_popcountll(m_word_mask) + 1) + 1;
+
+	std::vector<FaultIntersection *>& failures = dd->intersecting_ranges(m_word_bits, predicate, min_chips);
 
 	failures_t count = {0, 0};
-	for (auto fail: failures)
+	for (FaultIntersection *fail: failures)
 	{
-		if (fail.bit_count_sum(m_word_mask) > m_n_detect)
+		if (fail->bit_count_sum(m_word_mask) > m_n_detect)
 		{
-			fail.mark_undetectable();
+			fail->mark_undetectable();
 			count.undetected++;
 		}
 		else
 		{
-			fail.mark_uncorrectable();
+			fail->mark_uncorrectable();
 			count.uncorrected++;
 		}
 	}
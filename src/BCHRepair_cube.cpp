@@ -21,6 +21,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <iostream>
 #include <string>
+#include <algorithm>
 
 #include "BCHRepair_cube.hh"
 #include "DRAMDomain.hh"
@@ -32,9 +33,99 @@ BCHRepair_cube::BCHRepair_cube(std::string name, int n_correct, int n_detect, ui
 	, m_n_detect(n_detect)
 	, m_bitwidth(data_block_bits)
 	, m_log_block_bits(log2(data_block_bits))
+	, m_cover(), m_covered(), m_candidates()
 {
 }
 
+/** Set the bits of a block of 2^log_bits bits that are covered by the range (addr, mask), in any block */
+static void block_cover(uint64_t addr, uint64_t mask, unsigned log_bits, uint64_t *bits)
+{
+	// the positions in a word whose bit b is set
+	static const uint64_t positions[6] = {
+		0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+		0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+	};
+
+	uint64_t word = log_bits < 6 ? (1ULL << (1U << log_bits)) - 1 : ~0ULL;
+	for (unsigned b = 0; b < 6 && b < log_bits; b++)
+		if (!(mask >> b & 1))
+			word &= addr >> b & 1 ? positions[b] : ~positions[b];
+
+	const uint64_t n_words = log_bits < 6 ? 1 : 1ULL << (log_bits - 6);
+	const uint64_t word_addr = (addr >> 6) & (n_words - 1), word_mask = (mask >> 6) & (n_words - 1);
+	for (uint64_t w = 0; w < n_words; w++)
+		bits[w] = ((w ^ word_addr) & ~word_mask) == 0 ? word : 0ULL;
+}
+
+/** Count the faulty bits of the block at (addr, mask), which is narrowed down to the rows in common with the faults found
+ *
+ * Bits are tested in increasing order, each against the first fault of the chip that covers it. When that fault is more
+ * specific than the block (e.g. a row in a column), the rest of the block is only tested in the fault's range. Between
+ * two such narrowings, the faulty bits are the union of the bits covered by the remaining candidate faults.
+ */
+uint32_t BCHRepair_cube::block_errors(const FaultStore &faults, uint64_t addr, uint64_t mask)
+{
+	const uint64_t low = (1ULL << m_log_block_bits) - 1, block_size = low + 1;
+	const size_t n_words = m_log_block_bits < 6 ? 1 : block_size / 64;
+
+	uint64_t *covered = &m_covered[0];
+	uint32_t n_errors = 0;
+
+	for (uint64_t pos = 0; pos < block_size;)
+	{
+		// the first bit from pos where a narrowing fault is the first to cover it, if any
+		uint64_t event = block_size;
+		uint32_t event_fault = 0;
+		std::fill(covered, covered + n_words, 0ULL);
+
+		for (uint32_t i: m_candidates)
+		{
+			const uint64_t *cover = &m_cover[i * n_words];
+			if ((mask & ~faults.mask(i) & ~low) != 0)
+				for (size_t w = pos / 64; w < n_words && w * 64 < event; w++)
+				{
+					const uint64_t first = cover[w] & ~covered[w] & (w == pos / 64 ? ~0ULL << (pos % 64) : ~0ULL);
+					if (first && w * 64 + __builtin_ctzll(first) < event)
+					{
+						event = w * 64 + __builtin_ctzll(first);
+						event_fault = i;
+					}
+				}
+
+			for (size_t w = 0; w < n_words; w++)
+				covered[w] |= cover[w];
+		}
+
+		// count the covered bits in [pos, event]
+		const uint64_t until = std::min(event + 1, block_size);
+		for (size_t w = pos / 64; w * 64 < until; w++)
+		{
+			uint64_t bits = covered[w];
+			if (w == pos / 64)
+				bits &= ~0ULL << (pos % 64);
+			if (until < (w + 1) * 64)
+				bits &= (1ULL << (until % 64)) - 1;
+			n_errors += __builtin_popcountll(bits);
+		}
+
+		if (event == block_size)
+			break;
+
+		// narrow the block down to the range of the fault, and drop the faults that no longer intersect it
+		const uint64_t changed = mask & ~faults.mask(event_fault) & ~low;
+		addr = (faults.addr(event_fault) & changed) | (addr & ~changed);
+		mask &= ~changed;
+
+		m_candidates.erase(std::remove_if(m_candidates.begin(), m_candidates.end(), [&] (uint32_t i) {
+			return ((addr ^ faults.addr(i)) & ~(mask | faults.mask(i)) & ~low) != 0;
+		}), m_candidates.end());
+
+		pos = event + 1;
+	}
+
+	return n_errors;
+}
+
 failures_t BCHRepair_cube::repair(FaultDomain *fd)
 {
 	failures_t fail = {0, 0};
@@ -48,88 +139,54 @@ failures_t BCHRepair_cube::repair(FaultDomain *fd)
 		for (FaultRange *fr: dynamic_cast<DRAMDomain *>(cd)->getRanges())
 			fr->touched = 0;
 
+	const uint64_t low = (1ULL << m_log_block_bits) - 1; // ECC every 64 byte i.e 512 bit granularity
+	const size_t n_words = m_log_block_bits < 6 ? 1 : (low + 1) / 64;
+
 	// Take each chip in turn.  For every fault range in a chip, see which neighbors intersect it's ECC block(s).
 	// Count the failed bits in each ECC block.
 	for (FaultDomain *cd: pChips)
 	{
-		for (FaultRange *frOrg: dynamic_cast<DRAMDomain *>(cd)->getRanges())
-		{
-			FaultRange frTemp = *frOrg;
+		const FaultStore &faults = dynamic_cast<DRAMDomain *>(cd)->getRanges();
+
+		m_cover.resize(faults.size() * n_words);
+		m_covered.resize(n_words);
+		for (size_t i = 0; i < faults.size(); i++)
+			block_cover(faults.addr(i), faults.mask(i), m_log_block_bits, &m_cover[i * n_words]);
 
+		for (FaultRange *frOrg: faults)
+		{
 			uint32_t n_intersections = 0;
 
-			if (frTemp.touched < frTemp.max_faults)
+			if (frOrg->touched < frOrg->max_faults)
 			{
 				if (settings.debug)
-					std::cout << m_name << ": outer " << frTemp.toString() << "\n";
+					std::cout << m_name << ": outer " << frOrg->toString() << "\n";
 
-				unsigned bit_shift = m_log_block_bits; // ECC every 64 byte i.e 512 bit granularity
-				frTemp.fAddr = frTemp.fAddr >> bit_shift;
-				frTemp.fAddr = frTemp.fAddr << bit_shift;
-				frTemp.fWildMask = frTemp.fWildMask >> bit_shift;
-				frTemp.fWildMask = frTemp.fWildMask << bit_shift;
-				// This gives me the number of loops for the addresses near the fault range to iterate
-				unsigned loopcount_locations = 1 << bit_shift;
+				// the faults of the chip that intersect the block, outside of the bits of the block
+				const uint64_t addr = frOrg->fAddr & ~low, mask = frOrg->fWildMask & ~low;
+				m_candidates.clear();
+				for (uint32_t i = 0; i < faults.size(); i++)
+					if (faults[i]->touched < faults[i]->max_faults && ((addr ^ faults.addr(i)) & ~(mask | faults.mask(i)) & ~low) == 0)
+						m_candidates.push_back(i);
 
-				for (unsigned ii = 0; ii < loopcount_locations; ii++)
-				{
-					for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(cd)->getRanges())
-					{
-						if (settings.debug)
-							std::cout << m_name << ": inner " << fr1->toString() << " bit " << ii << "\n";
-
-						if (fr1->touched < fr1->max_faults)
-						{
-							if (frTemp.intersects(fr1))
-							{
-								if (settings.debug)
-									std::cout << m_name << ": INTERSECT " << n_intersections << "\n";
-
-								n_intersections++;
-
-								// There was a failed bit in at least one row of the FaultRange of interest.
-								// We now only care about further intersections that are in the overlapping
-								// rows of the two ranges.  Narrow down the search to only those rows in common
-								// to both FaultRanges.  This is achieved by;
-								// 1) Set upper mask bits to zero if they are not wild in range under test
-								// 2) For those wild bits that we cleared, use the specific address bit value
-								uint64_t fr1_fAddr_upper = (fr1->fAddr >> bit_shift) << bit_shift;
-								uint64_t frTemp_fAddr_lower = (frTemp.fAddr & ((0x1 << bit_shift) - 1));
-
-								uint64_t old_wild_mask = frTemp.fWildMask;
-								frTemp.fWildMask &= fr1->fWildMask;
-								uint64_t changed_wild_bits = old_wild_mask ^ frTemp.fWildMask;
-								frTemp.fAddr = (fr1_fAddr_upper & changed_wild_bits) | (frTemp.fAddr & (~changed_wild_bits)) | frTemp_fAddr_lower;
-
-								// immediately move on to the next location
-								break;
-							}
-							else
-							{
-								if (settings.debug)
-									std::cout << m_name << ": NONE " << n_intersections << "\n";
-							}
-						}
-					}
-					frTemp.fAddr = frTemp.fAddr + 1;
-				}
+				n_intersections = block_errors(faults, addr, mask);
+			}
 
-				// For this algorithm, one intersection with the bit being tested actually means one
-				// faulty bit in the
-				if (n_intersections <= m_n_correct)
-				{
-					// correctable
-				}
-				if (n_intersections > m_n_correct)
-				{
-					fail.uncorrected += (n_intersections - m_n_correct);
-					frOrg->transient_remove = false;
-					if (!settings.continue_running)
-						return fail;
-				}
-				if (n_intersections >= m_n_detect)
-					fail.undetected += (n_intersections - m_n_detect);
+			// For this algorithm, one intersection with the bit being tested actually means one
+			// faulty bit in the
+			if (n_intersections <= m_n_correct)
+			{
+				// correctable
+			}
+			if (n_intersections > m_n_correct)
+			{
+				fail.uncorrected += (n_intersections - m_n_correct);
+				frOrg->transient_remove = false;
+				if (!settings.continue_running)
+					return fail;
 			}
+			if (n_intersections >= m_n_detect)
+				fail.undetected += (n_intersections - m_n_detect);
 		}
 	}
 
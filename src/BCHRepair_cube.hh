@@ -23,9 +23,11 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define BCHREPAIR_CUBE_HH_
 
 #include <string>
+#include <vector>
 
 #include "RepairScheme.hh"
 #include "GroupDomain.hh"
+#include "FaultStore.hh"
 
 class BCHRepair_cube : public RepairScheme
 {
@@ -38,6 +40,12 @@ public:
 
 private:
 	const uint64_t m_n_correct, m_n_detect, m_bitwidth, m_log_block_bits;
+
+	/** Bits of a block covered by each fault of a chip, their union, and the faults that may intersect the block under test */
+	std::vector<uint64_t> m_cover, m_covered;
+	std::vector<uint32_t> m_candidates;
+
+	uint32_t block_errors(const FaultStore &faults, uint64_t addr, uint64_t mask);
 };
 
 
@@ -21,7 +21,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
 #include <list>
-#include <map>
+#include <vector>
+#include <tuple>
+#include <algorithm>
 #include <cassert>
 
 #include "FaultRange.hh"
@@ -30,43 +32,113 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "BCHRepair_inDRAM.hh"
 
 
-void BCHRepair_inDRAM::insert(std::list<FaultRange*> &list, FaultIntersection &err)
+BCHRepair_inDRAM::codeword_t &BCHRepair_inDRAM::find_codeword(DRAMDomain *dram, codeword_table_t &table, FaultRange *fr)
 {
-	FaultIntersection *modified = new FaultIntersection(std::move(err));
-	modified_ranges.insert(modified);
-	list.push_back(dynamic_cast<FaultRange*>(modified));
+	// NB: this is the number of columns in a codeword *before* correction
+	const size_t codeword_cols_in = (m_base_size + m_extra_size) / dram->getNum<Bits>();
+
+	const uint64_t bank = fr->fAddr & (dram->getMask<Ranks>() | dram->getMask<Banks>());
+	const bool in_row = dram->has<Rows>(fr->fWildMask);
+	const uint32_t index = dram->get<Cols>(fr->fAddr) / codeword_cols_in;
+	const uint32_t row = in_row ? dram->get<Rows>(fr->fAddr) : 0;
+	const auto key = std::make_tuple(bank, in_row, index, row);
+
+	auto it = std::lower_bound(table.codewords.begin(), table.codewords.end(), key,
+							   [] (const codeword_t &codeword, decltype(key) &k) { return codeword.key() < k; });
+	if (it == table.codewords.end() || it->key() != key)
+		it = table.codewords.insert(it, codeword_t{bank, in_row, index, row, {}, {}, nullptr, false});
+
+	return *it;
 }
 
 
-std::map<uint64_t, std::list<FaultRange*>> BCHRepair_inDRAM::sort_per_bank(std::list<FaultRange*> &list)
+void BCHRepair_inDRAM::update_codewords(DRAMDomain *dram, codeword_table_t &table)
 {
-	// sort per bank into buckets
-	std::map<uint64_t, std::list<FaultRange*>> bank_ranges;
-	for (auto it = list.begin(); it != list.end();)
-	{
-		FaultRange *fault = *it;
-		DRAMDomain *dram = fault->m_pDRAM;
+	FaultStore &faults = dram->getRanges();
 
-		fault_class_t cls = dram->maskClass(fault->fWildMask);
+	auto remove = [&] (FaultRange *fr) {
+		codeword_t &codeword = find_codeword(dram, table, fr);
+		codeword.faults.erase(std::find(codeword.faults.begin(), codeword.faults.end(), fr));
+		codeword.changed = true;
+	};
+
+	// Faults are only ever appended to a chip or removed from it, so the known faults are met in the same order
+	std::vector<FaultRange*> small_faults;
+	small_faults.reserve(table.known_faults.size() + 1);
+
+	size_t known = 0;
+	for (size_t i = 0; i < faults.size(); i++)
+	{
 		// Leave big errors out of this
-		if (cls > DRAM_1COL)
+		if (faults.fault_class(i) > DRAM_1COL)
 		{
-			assert(not dram->has<Cols>(fault->fWildMask));
-			++it;
+			assert(not dram->has<Cols>(faults.mask(i)));
 			continue;
 		}
 
 		// DRAM_1COL or DRAM_1WORD or DRAM_1BIT
-		uint64_t bank_address = fault->fAddr;
-		dram->put<Cols>(bank_address, 0U);
-		dram->put<Bits>(bank_address, 0U);
+		FaultRange *fr = faults[i];
+		while (known < table.known_faults.size() && table.known_faults[known] != fr)
+			remove(table.known_faults[known++]);
 
-		bank_ranges[bank_address].push_back(fault);
+		if (known < table.known_faults.size())
+			known++;
+		else
+		{
+			codeword_t &codeword = find_codeword(dram, table, fr);
+			codeword.faults.push_back(fr);
+			codeword.changed = true;
+		}
 
-		it = list.erase(it);
+		small_faults.push_back(fr);
 	}
 
-	return bank_ranges;
+	while (known < table.known_faults.size())
+		remove(table.known_faults[known++]);
+
+	table.known_faults.swap(small_faults);
+
+	for (codeword_t &codeword: table.codewords)
+		if (codeword.changed)
+			set_bits(dram, codeword);
+}
+
+
+void BCHRepair_inDRAM::set_bits(DRAMDomain *dram, codeword_t &codeword)
+{
+	const size_t n_bits = dram->getNum<Bits>(), codeword_size = m_base_size + m_extra_size;
+	const uint32_t first_col = codeword.index * (codeword_size / n_bits);
+
+	codeword.bits.assign((codeword_size + 63) / 64, 0ULL);
+	for (FaultRange *fr: codeword.faults)
+	{
+		const uint32_t col_mask = dram->get<Cols>(fr->fWildMask), col = dram->get<Cols>(fr->fAddr) & ~col_mask;
+		const uint32_t bit_mask = dram->get<Bits>(fr->fWildMask), bit = dram->get<Bits>(fr->fAddr) & ~bit_mask;
+
+		for (size_t pos = 0; pos < codeword_size; pos++)
+			if (((first_col + pos / n_bits) & ~col_mask) == col && ((pos % n_bits) & ~bit_mask) == bit)
+				codeword.bits[pos / 64] |= 1ULL << (pos % 64);
+	}
+}
+
+
+FaultIntersection *BCHRepair_inDRAM::make_failure(DRAMDomain *dram, const codeword_t &codeword, const codeword_t *all_rows)
+{
+	// NB: this is the number of columns in a codeword *after* correction
+	const size_t codeword_cols_out = m_base_size / dram->getNum<Bits>();
+
+	FaultIntersection failure;
+	for (FaultRange *fr: codeword.faults)
+		failure.intersection(fr, m_base_size - 1);
+	if (all_rows)
+		for (FaultRange *fr: all_rows->faults)
+			failure.intersection(fr, m_base_size - 1);
+
+	// Renumber the column post-ECC
+	dram->put<Cols>(failure.fAddr, codeword.index * codeword_cols_out);
+
+	// the error lives until the end of the simulation, in the group's arena
+	return dram->get_group().arena().make<FaultIntersection>(std::move(failure));
 }
 
 
@@ -80,69 +152,57 @@ failures_t BCHRepair_inDRAM::repair(FaultDomain *fd)
 		std::abort();
 	}
 
-	std::list<FaultRange*> &raw_faults = dram->getRanges();
+	if (m_tables.size() <= dram->getChipNum())
+		m_tables.resize(dram->getChipNum() + 1);
 
-	// NB: this is the number of columns in a codeword *before* correction
-	const size_t codeword_cols_in = (m_base_size + m_extra_size) / dram->getNum<Bits>();
-	const size_t codewords_per_row = dram->getNum<Cols>() / codeword_cols_in;
-	// NB: this is the number of columns in a codeword *after* correction
-	const size_t codeword_cols_out = m_base_size / dram->getNum<Bits>();
+	// Only the codewords whose faults changed since the last repair of the chip are checked again
+	codeword_table_t &table = m_tables[dram->getChipNum()];
+	update_codewords(dram, table);
 
-	for (auto &bank_ranges: sort_per_bank(raw_faults))
-	{
-		std::map<int32_t, FaultIntersection> columns;
-		std::map<std::pair<int32_t, int32_t>, FaultIntersection> words;
+	auto all_rows = [&table] (const codeword_t &codeword) -> const codeword_t * {
+		if (!codeword.in_row)
+			return nullptr;
 
-		for (FaultRange *err: bank_ranges.second)
-		{
-			size_t codeword = dram->get<Cols>(err->fAddr) / codeword_cols_in;
-			FaultIntersection add(err, m_base_size - 1);
+		const auto key = std::make_tuple(codeword.bank, false, codeword.index, 0U);
+		auto it = std::lower_bound(table.codewords.begin(), table.codewords.end(), key,
+								   [] (const codeword_t &other, decltype(key) &k) { return other.key() < k; });
+		return it != table.codewords.end() && it->key() == key ? &*it : nullptr;
+	};
 
-			// Renumber the column post-ECC
-			dram->put<Cols>(add.fAddr, codeword * codeword_cols_out);
+	// Codewords in a row also hold the faults of the codewords at the same position in all rows
+	for (codeword_t &codeword: table.codewords)
+	{
+		const codeword_t *column = all_rows(codeword);
+		if (!codeword.changed && !(column && column->changed))
+			continue;
 
-			if (not dram->has<Rows>(err->fWildMask))
-				columns[codeword].intersection(add);
-			else
-				words[std::make_pair(codeword, dram->get<Rows>(err->fAddr))].intersection(add);
-		}
+		size_t wrong_bits = 0;
+		for (size_t i = 0; i < codeword.bits.size(); i++)
+			wrong_bits += __builtin_popcountll(codeword.bits[i] | (column ? column->bits[i] : 0ULL));
 
-		std::vector<bool> failed_codeword_columns(codewords_per_row, false);
-		for (auto column_error_it = columns.begin(); column_error_it != columns.end();)
-		{
-			FaultIntersection& col_err = column_error_it->second;
-
-			if (col_err.bit_count_aggregate(m_base_size + m_extra_size) > m_n_correct)
-			{
-				failed_codeword_columns[column_error_it->first] = true;
-				insert(raw_faults, col_err);
-				column_error_it = columns.erase(column_error_it);
-			}
-			else
-				++column_error_it;
-		}
+		codeword.failure = wrong_bits > m_n_correct && !codeword.faults.empty() ? make_failure(dram, codeword, column) : nullptr;
+	}
 
-		int32_t row, codeword;
-		auto column_error_it = columns.begin();
-		for (auto &codeword_error_pair: words)
-		{
-			std::tie(codeword, row) = codeword_error_pair.first;
-			FaultIntersection &word_err = codeword_error_pair.second;
+	table.codewords.erase(std::remove_if(table.codewords.begin(), table.codewords.end(),
+										 [] (codeword_t &codeword) { return codeword.faults.empty(); }),
+						  table.codewords.end());
 
-			// skip a full column already failed
-			if (failed_codeword_columns[codeword])
-				continue;
+	// Replace the small faults with the uncorrectable errors
+	FaultStore &raw_faults = dram->getRanges();
+	raw_faults.remove_if([&raw_faults] (size_t i) { return raw_faults.fault_class(i) <= DRAM_1COL; });
 
-			// find if there is a column error that matches this codeword
-			while (column_error_it != columns.end() && column_error_it->first < codeword)
-				++column_error_it;
+	for (codeword_t &codeword: table.codewords)
+	{
+		codeword.changed = false;
 
-			if (column_error_it != columns.end() && column_error_it->first == codeword)
-				word_err.intersection(column_error_it->second);
+		// skip a codeword in a row when the codewords at its position in all rows already failed
+		const codeword_t *column = all_rows(codeword);
+		if (codeword.failure == nullptr || (column && column->failure))
+			continue;
 
-			if (word_err.bit_count_aggregate(m_base_size + m_extra_size) > m_n_correct)
-				insert(raw_faults, word_err);
-		}
+		// as if the error was built anew from the faults at each repair
+		codeword.failure->transient_remove = codeword.failure->transient;
+		raw_faults.push_back(codeword.failure, dram->maskClass(codeword.failure->fWildMask));
 	}
 
 	return {raw_faults.size(), raw_faults.size()};
@@ -24,6 +24,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <set>
 #include <list>
+#include <vector>
 #include <tuple>
 #include <string>
 #include <algorithm>
@@ -41,10 +42,41 @@ class BCHRepair_inDRAM : public RepairScheme
 protected:
 	size_t m_base_size, m_extra_size, m_n_correct;
 
-	std::set<FaultIntersection *> modified_ranges;
+	/** A codeword with faults: in a single row, or the codewords at this position in all rows of the bank */
+	struct codeword_t
+	{
+		// rank and bank address, whether the codeword is in a single row, the codeword position in the row, and the row
+		uint64_t bank;
+		bool in_row;
+		uint32_t index, row;
+
+		/** Faults in the codeword, the codeword bits they may corrupt, and their error when uncorrectable */
+		std::vector<FaultRange*> faults;
+		std::vector<uint64_t> bits;
+		FaultIntersection *failure;
+		bool changed;
+
+		inline
+		std::tuple<uint64_t, bool, uint32_t, uint32_t> key() const
+		{
+			return std::make_tuple(bank, in_row, index, row);
+		}
+	};
+
+	/** Codewords with faults of a chip, sorted per bank with the all-rows codewords first, and the faults they hold */
+	struct codeword_table_t
+	{
+		std::vector<codeword_t> codewords;
+		std::vector<FaultRange*> known_faults;
+	};
 
-	void insert(std::list<FaultRange*> &list, FaultIntersection &err);
-	std::map<uint64_t, std::list<FaultRange*>> sort_per_bank(std::list<FaultRange*> &list);
+	/** The tables of each chip, updated with the faults inserted or scrubbed since the chip's last repair */
+	std::vector<codeword_table_t> m_tables;
+
+	codeword_t &find_codeword(DRAMDomain *dram, codeword_table_t &table, FaultRange *fr);
+	void update_codewords(DRAMDomain *dram, codeword_table_t &table);
+	void set_bits(DRAMDomain *dram, codeword_t &codeword);
+	FaultIntersection *make_failure(DRAMDomain *dram, const codeword_t &codeword, const codeword_t *all_rows);
 
 public:
 	BCHRepair_inDRAM(std::string name, size_t code = 136, size_t data = 128)
@@ -76,10 +108,11 @@ public:
 
 	virtual void reset()
 	{
-		for (auto &fr: modified_ranges)
-			delete fr;
-
-		modified_ranges.clear();
+		for (codeword_table_t &table: m_tables)
+		{
+			table.codewords.clear();
+			table.known_faults.clear();
+		}
 	}
 
 	virtual void printStats() {}
@@ -37,7 +37,7 @@ ChipKillRepair::ChipKillRepair(std::string name, int n_sym_correct, int n_sym_de
 failures_t ChipKillRepair::repair(FaultDomain *fd)
 {
 	GroupDomain_dimm *dd = dynamic_cast<GroupDomain_dimm *>(fd);
-	auto predicate = [this](FaultIntersection &error) { return error.chip_count() > m_n_correct; };
+	auto predicate = [this](auto &error) { return error.chip_count() > m_n_correct; };
 
 	const size_t log2_data_chips = floor(log2(dd->chips()));
 	size_t symbol_bits = floor(log2(dd->burst_size() >> log2_data_chips));
@@ -49,19 +49,19 @@ failures_t ChipKillRepair::repair(FaultDomain *fd)
 		std::abort();
 	}
 
-	std::list<FaultIntersection>& failures = dd->intersecting_ranges(symbol_bits, predicate);
+	std::vector<FaultIntersection *>& failures = dd->intersecting_ranges(symbol_bits, predicate, m_n_correct + 1);
 
 	failures_t count = {0, 0};
-	for (auto &fail: failures)
+	for (FaultIntersection *fail: failures)
 	{
-		if (fail.chip_count() > m_n_detect)
+		if (fail->chip_count() > m_n_detect)
 		{
-			fail.mark_undetectable();
+			fail->mark_undetectable();
 			count.undetected++;
 		}
 		else
 		{
-			fail.mark_uncorrectable();
+			fail->mark_uncorrectable();
 			count.uncorrected++;
 		}
 	}
@@ -39,6 +39,12 @@ public:
 	failures_t repair(FaultDomain *fd);
 	virtual void reset() {};
 
+	unsigned failure_threshold() const
+	{
+		// Needs more symbols, thus more chips, with errors than can be corrected
+		return m_n_correct + 1;
+	}
+
 protected:
 	const uint64_t m_n_correct, m_n_detect;
 
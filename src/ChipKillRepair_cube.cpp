@@ -20,7 +20,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <string>
-#include <time.h>
+#include <algorithm>
 
 #include "ChipKillRepair_cube.hh"
 #include "DRAMDomain.hh"
@@ -29,194 +29,74 @@ ChipKillRepair_cube::ChipKillRepair_cube(std::string name, int n_sym_correct, in
 	: RepairScheme(name)
 	, m_n_correct(n_sym_correct)
 	, m_n_detect(n_sym_detect)
+	, m_horizontal(fd->horizontalTSV())
+	, m_buckets(), m_symbols()
 {
-	DRAMDomain *DRAMchip = dynamic_cast<DRAMDomain *>(fd->getChildren().front());
-	logBits = DRAMchip->getLog<Bits>();
-	logCols = DRAMchip->getLog<Cols>();
-	logRows = DRAMchip->getLog<Rows>();
-	banks = 1 << DRAMchip->getLog<Banks>();
 }
 
 failures_t ChipKillRepair_cube::repair(FaultDomain *fd)
 {
-	// Choose the algorithm based on the whether its modelled as vertical channels or horizontal channels
 	GroupDomain_cube *cd = dynamic_cast<GroupDomain_cube *>(fd);
+	std::list<FaultDomain *> &pChips = cd->getChildren();
+	const DRAMDomain *front = dynamic_cast<DRAMDomain *>(pChips.front());
+
+	// Choose the symbols based on the whether its modelled as vertical channels or horizontal channels
+	const bool horizontal = m_horizontal;
+	const uint32_t banks = front->getNum<Banks>();
+	const uint64_t n_symbols = horizontal ? banks : cd->chips();
+
+	// each symbol holds an equal share of the burst
+	const uint64_t symbol_mask = cd->burst_size() / n_symbols - 1;
+	// with horizontal channels, a codeword spans all banks
+	const uint64_t codeword_mask = symbol_mask | (horizontal ? front->getMask<Banks>() : 0);
+	// faults in different ranks or rows never intersect
+	const uint64_t key_mask = front->getMask<Ranks>() | front->getMask<Rows>();
+
+	m_buckets.resize(horizontal ? cd->chips() : banks);
+	for (auto &bucket: m_buckets)
+		bucket.clear(key_mask, n_symbols);
+	m_symbols.clear();
 
-	if (cd->horizontalTSV())
-		return repair_horizontalTSV(cd);
-	else
-		return repair_verticalTSV(cd);
-}
-
-
-failures_t ChipKillRepair_cube::repair_horizontalTSV(GroupDomain_cube *fd)
-{
-	failures_t fail = {0, 0};
-	std::list<FaultDomain *> &pChips = fd->getChildren();
-	//Initialize the counters to count chips
-	uint64_t counter1 = 0;
-	uint64_t counter2 = 0;
-
-	int64_t bank_number1 = 0;
-	int64_t bank_number2 = 0;
-
-	//Clear out the touched values for all chips
-	for (FaultDomain *fd: pChips)
-		for (FaultRange *fr: dynamic_cast<DRAMDomain *>(fd)->getRanges())
-			fr->touched = 0;
-
-
-	//Take the 1st Chip and check if other chips also fail. We use only upto 8 chips
 	for (FaultDomain *fd0: pChips)
 	{
-		// For each fault in first chip, query the second chip to see if it has an intersecting fault range.
-		for (FaultRange *fr0: dynamic_cast<DRAMDomain *>(fd0)->getRanges())
+		DRAMDomain *chip = dynamic_cast<DRAMDomain *>(fd0);
+		for (FaultRange *fr: chip->getRanges())
 		{
-			// Make a copy, otherwise fault is modified as a side-effect
-			FaultRange frTemp = *fr0;
-			//8 Bytes are protected per chip
-			frTemp.fWildMask = ((0x1 << 6) - 1);
-			uint32_t n_intersections = 0;
-			counter2 = 0;
-			// for each other chip, count number of intersecting faults
-			for (uint64_t ii = 0; ii < banks; ii++)
+			// Split faults over several banks into a range per bank
+			const uint32_t bank_mask = chip->get<Banks>(fr->fWildMask), bank_addr = chip->get<Banks>(fr->fAddr) & ~bank_mask;
+			for (uint32_t bank = 0; bank < banks; bank++)
 			{
-				//Adjusting for number of banks
-				uint64_t bit_shift = logBits + logRows + logCols;
-				uint64_t and_value = 1 << (logBits + logRows + logCols);
-				and_value = and_value - 1;
-				uint64_t lower_addr = frTemp.fAddr & and_value;
-				frTemp.fAddr = frTemp.fAddr >> (3 + bit_shift);     //8 Banks
-				frTemp.fAddr = frTemp.fAddr << 3;
-				frTemp.fAddr = frTemp.fAddr + ii;
-				frTemp.fAddr = frTemp.fAddr << bit_shift;
-				frTemp.fAddr = frTemp.fAddr | lower_addr;
+				if ((bank & ~bank_mask) != bank_addr)
+					continue;
 
-				//Start looping accross chips
-				for (FaultDomain *fd1: pChips)
-				{
-					if (counter1 < 2 && counter2 < 2)
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-							if (frTemp.intersects(fr1))
-							{
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-							}
-					}
-					if ((counter1 < 2 || counter2 < 2) && (counter1 == 4 || counter2 == 4))
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-						{
-							bank_number2 = getbank_number(*fr1);
-							if (bank_number1 != -1 && bank_number2 != -1)
-							{
-								if (bank_number2 == (bank_number1 >> 1))
-								{
-									if (frTemp.intersects(fr1))
-									{
-										// count the intersection
-										n_intersections++;
-										fr1->touched++;
-										break;
-									}
-								}
-							}
-							else if ((bank_number1 == -1) && (bank_number2 < 4) && (bank_number2 > -1))
-							{
-								if (frTemp.intersects(fr1))
-								{
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-
-							}
-							else if ((bank_number2 == -1))
-							{
-								if (frTemp.intersects(fr1))
-								{
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-
-							}
-						}
-					}
-					if (counter1 > 1 && counter1 < 4 && counter2 > 1 && counter2 < 4)
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-							if (frTemp.intersects(fr1))
-							{
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-							}
-					}
-					if (((counter1 > 1 && counter1 < 4) || (counter2 > 1 && counter2 < 4)) && (counter1 == 4 || counter2 == 4))
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-						{
-							bank_number2 = getbank_number(*fr1);
-							if (bank_number2 == ((bank_number1 >> 1) | 0x4))
-							{
-								if (frTemp.intersects(fr1))
-								{
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-							}
-						}
-					}
-					if (counter1 > 4 && counter1 < 7 && counter2 > 4 && counter2 < 7)
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-							if (frTemp.intersects(fr1))
-							{
-								// count the intersection
-								n_intersections++;
-								fr1->touched++;
-								break;
-							}
-					}
-					if (((counter1 > 4 && counter1 < 7) || (counter2 > 4 && counter2 < 7)) && (counter1 == 7 || counter2 == 7))
-					{
-						for (FaultRange *fr1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-						{
-							bank_number2 = getbank_number(*fr1);
-							if (bank_number2 == (bank_number1 >> 1))
-							{
-								if (frTemp.intersects(fr1))
-								{
-									// count the intersection
-									n_intersections++;
-									fr1->touched++;
-									break;
-								}
-							}
-						}
-					}
-					counter2++;
-				}
+				m_buckets[horizontal ? chip->getChipNum() : bank].push_back({
+					chip->set<Banks>(fr->fAddr, bank), (fr->fWildMask & ~chip->getMask<Banks>()) | codeword_mask,
+					horizontal ? bank : chip->getChipNum(), static_cast<uint32_t>(m_symbols.size())
+				});
 			}
-			if (n_intersections > m_n_correct)
-				fail.uncorrected += n_intersections - m_n_correct;
-			if (n_intersections > m_n_detect)
-				fail.undetected += n_intersections - m_n_detect;
+			m_symbols.push_back(0);
 		}
 	}
-	return fail;
-}
 
-failures_t ChipKillRepair_cube::repair_verticalTSV(GroupDomain_cube *fd [[gnu::unused]])
-{
-	return {0, 0};
+	for (auto &bucket: m_buckets)
+	{
+		bucket.sort();
+
+		// the symbols intersecting a fault include its own
+		for (const auto *faults: {&bucket.keyed(), &bucket.wild()})
+			for (const FaultBucket::fault_t &fault: *faults)
+				m_symbols[fault.index] = std::max(m_symbols[fault.index], bucket.intersecting_groups(fault) + 1);
+	}
+
+	// each fault fails with the number of symbols of its worst codeword
+	failures_t fail = {0, 0};
+	for (uint32_t n_intersections: m_symbols)
+	{
+		if (n_intersections > m_n_correct)
+			fail.uncorrected += n_intersections - m_n_correct;
+		if (n_intersections > m_n_detect)
+			fail.undetected += n_intersections - m_n_detect;
+	}
+
+	return fail;
 }
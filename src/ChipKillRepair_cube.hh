@@ -23,13 +23,22 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define CHIPKILLREPAIR_CUBE_HH_
 
 #include <string>
+#include <vector>
 
 #include "RepairScheme.hh"
 #include "GroupDomain.hh"
 #include "GroupDomain_cube.hh"
 #include "FaultRange.hh"
 #include "DRAMDomain.hh"
+#include "FaultBucket.hh"
 
+/** ChipKill for 3D stacks, where the symbols of a codeword come from the channel that serves it
+ *
+ * With vertical channels, that span all the chips (dies) of the stack at a given bank, a codeword has a symbol in every
+ * chip at the same bank and address. With horizontal channels, one per chip, a codeword has a symbol in every bank of
+ * a chip at the same address. Faults are sorted into a FaultBucket per bank (resp. chip), keyed by rank and row, so
+ * that each fault is only checked against the faults of its bucket at the same rank and row, and those over many rows.
+ */
 class ChipKillRepair_cube : public RepairScheme
 {
 public:
@@ -38,20 +47,19 @@ public:
 	failures_t repair(FaultDomain *fd);
 	void reset() {};
 
-private:
-	failures_t repair_horizontalTSV(GroupDomain_cube *fd);
-	failures_t repair_verticalTSV(GroupDomain_cube *fd);
-
-	inline int64_t getbank_number(FaultRange &fr)
+	/** With horizontal channels, a single fault over several banks of a chip has several symbols in a codeword */
+	unsigned failure_threshold() const
 	{
-		if (fr.m_pDRAM->has<Banks>(fr.fWildMask))
-			return fr.m_pDRAM->get<Banks>(fr.fAddr);
-		else
-			return -1;
+		return m_horizontal ? 1 : m_n_correct + 1;
 	}
 
+private:
 	const uint64_t m_n_correct, m_n_detect;
-	uint32_t logBits, logCols, logRows, banks;
+	const bool m_horizontal;
+
+	/** Faults per bucket, grouped by symbol, and the largest number of symbols that each fault intersects */
+	std::vector<FaultBucket> m_buckets;
+	std::vector<uint32_t> m_symbols;
 };
 
 
@@ -0,0 +1,112 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CHIPOCCUPANCY_HH_
+#define CHIPOCCUPANCY_HH_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/** Which chips of a group hold faults in each (rank, bank)
+ *
+ * Faults are counted per chip in the slot of their (rank, bank), or of their rank when they span all of its banks, or in
+ * a last slot when they span all ranks. A chip occupies a (rank, bank) if it has faults in any of the 3 matching slots.
+ * Counts are updated as faults are inserted and removed, so that the chip bitmasks are always available.
+ */
+class ChipOccupancy
+{
+	size_t m_chips, m_ranks, m_banks;
+	std::vector<uint32_t> m_count;
+	std::vector<uint64_t> m_occupied;
+
+public:
+	ChipOccupancy() : m_chips(0), m_ranks(0), m_banks(0), m_count(), m_occupied() {}
+
+	/** Size for a group of chips (at most 64), clearing all faults */
+	inline
+	void resize(size_t chips, size_t ranks, size_t banks)
+	{
+		m_chips = chips;
+		m_ranks = ranks;
+		m_banks = banks;
+		m_count.assign((ranks * banks + ranks + 1) * chips, 0);
+		m_occupied.assign(ranks * banks + ranks + 1, 0);
+	}
+
+	inline bool empty() const { return m_occupied.empty(); }
+
+	inline size_t bank_slot(size_t rank, size_t bank) const { return rank * m_banks + bank; }
+	inline size_t rank_slot(size_t rank) const { return m_ranks * m_banks + rank; }
+	inline size_t all_slot() const { return m_ranks * m_banks + m_ranks; }
+
+	inline
+	void add(size_t slot, unsigned chip)
+	{
+		if (m_count[slot * m_chips + chip]++ == 0)
+			m_occupied[slot] |= 1ULL << chip;
+	}
+
+	inline
+	void remove(size_t slot, unsigned chip)
+	{
+		if (--m_count[slot * m_chips + chip] == 0)
+			m_occupied[slot] &= ~(1ULL << chip);
+	}
+
+	inline
+	void clear()
+	{
+		std::fill(m_count.begin(), m_count.end(), 0);
+		std::fill(m_occupied.begin(), m_occupied.end(), 0);
+	}
+
+	inline
+	void clear(unsigned chip)
+	{
+		for (size_t slot = 0; slot < m_occupied.size(); slot++)
+		{
+			m_count[slot * m_chips + chip] = 0;
+			m_occupied[slot] &= ~(1ULL << chip);
+		}
+	}
+
+	/** Bitmask of the chips that have faults in the given (rank, bank) */
+	inline
+	uint64_t chips(size_t rank, size_t bank) const
+	{
+		return m_occupied[bank_slot(rank, bank)] | m_occupied[rank_slot(rank)] | m_occupied[all_slot()];
+	}
+
+	/** Maximum number of chips that have faults in a same (rank, bank) */
+	inline
+	unsigned max_chips() const
+	{
+		unsigned level = 0;
+		for (size_t rank = 0; rank < m_ranks; rank++)
+			for (size_t bank = 0; bank < m_banks; bank++)
+				level = std::max(level, static_cast<unsigned>(__builtin_popcountll(chips(rank, bank))));
+		return level;
+	}
+};
+
+#endif /* CHIPOCCUPANCY_HH_ */
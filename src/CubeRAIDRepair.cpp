@@ -32,6 +32,7 @@ CubeRAIDRepair::CubeRAIDRepair(std::string name, unsigned n_sym_correct, unsigne
 	, m_n_detect(n_sym_detect)
 	, m_data_block_bits(data_block_bits)
 	, m_log_block_bits(log2(data_block_bits))
+	, m_faults()
 {
 }
 
@@ -42,52 +43,41 @@ failures_t CubeRAIDRepair::repair(FaultDomain *fd)
 	// Repair this module.  Assume 8-bit symbols.
 
 	std::list<FaultDomain *> &pChips = cd->getChildren();
+	const DRAMDomain *front = dynamic_cast<DRAMDomain *>(pChips.front());
 
 	//Clear out the touched values for all chips
 	for (FaultDomain *cd: pChips)
 		for (FaultRange *fr: dynamic_cast<DRAMDomain *>(cd)->getRanges())
 			fr->touched = 0;
 
+	// Round the FR size to that of a detection block (e.g. cache line)
+	const uint64_t block_mask = (1ULL << m_log_block_bits) - 1;
+	const uint64_t key_mask = front->getMask<Ranks>() | front->getMask<Banks>() | front->getMask<Rows>();
+
+	m_faults.clear(key_mask, pChips.size());
+
+	uint32_t chip = 0;
+	for (FaultDomain *fd0: pChips)
+	{
+		for (FaultRange *fr: dynamic_cast<DRAMDomain *>(fd0)->getRanges())
+			if (fr->touched < fr->max_faults)
+				m_faults.push_back({fr->fAddr, fr->fWildMask | block_mask, chip, 0});
+		chip++;
+	}
+
+	m_faults.sort();
+
 	// Take each chip in turn.  For every fault range,
-	// count the number of intersecting faults.
+	// count the number of chips with an intersecting fault.
 	// if count exceeds correction ability, fail.
+	chip = 0;
 	for (FaultDomain *fd0: pChips)
 	{
-		// For each fault in first chip, query the other chips to see if they have
-		// an intersecting fault range.
 		for (FaultRange *frOrg0: dynamic_cast<DRAMDomain *>(fd0)->getRanges())
 		{
-			// Round the FR size to that of a detection block (e.g. cache line)
-			// on a copy, otherwise fault is modified as a side-effect
-			FaultRange frTemp0 = *frOrg0;
-			frTemp0.fWildMask |= ((1 << m_log_block_bits) - 1);
-
 			uint32_t n_intersections = 0;
-			if (frTemp0.touched < frTemp0.max_faults)
-			{
-				// for each other chip, count number of intersecting faults
-				for (FaultDomain *fd1: pChips)
-				{
-					if (fd0 == fd1) continue;    // skip if we're looking at the first chip
-
-					for (FaultRange *frOrg1: dynamic_cast<DRAMDomain *>(fd1)->getRanges())
-					{
-						// round the FR size to that of a detection block (e.g. cache line)
-						FaultRange frTemp1 = *frOrg1;
-						frTemp1.fWildMask |= ((1 << m_log_block_bits) - 1);
-
-						if (frTemp1.touched < frTemp1.max_faults)
-						{
-							if (frTemp0.intersects(&frTemp1))
-							{
-								// count the intersection
-								n_intersections++;
-								break;
-							}
-						}
-					}
-				}
-			}
+			if (frOrg0->touched < frOrg0->max_faults)
+				n_intersections = m_faults.intersecting_groups({frOrg0->fAddr, frOrg0->fWildMask | block_mask, chip, 0});
 
 			// 1 intersection implies 2 overlapping faults
 			if (n_intersections < m_n_correct)
@@ -106,6 +96,7 @@ failures_t CubeRAIDRepair::repair(FaultDomain *fd)
 			if (n_intersections >= m_n_detect)
 				fail.undetected += (n_intersections + 1 - m_n_detect);
 		}
+		chip++;
 	}
 
 	return fail;
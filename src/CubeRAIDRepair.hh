@@ -26,7 +26,14 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "RepairScheme.hh"
 #include "GroupDomain.hh"
-
+#include "FaultBucket.hh"
+
+/** RAID across the chips (dies) of a 3D stack, where a detection block fails when faults of several chips intersect it
+ *
+ * The faults of all the chips, rounded to detection blocks, are sorted once by their rank, bank and row in a FaultBucket.
+ * Each fault is then only checked against the faults at the same rank, bank and row, and the faults that wildcard any
+ * of these.
+ */
 class CubeRAIDRepair : public RepairScheme
 {
 public:
@@ -35,8 +42,16 @@ public:
 	failures_t repair(FaultDomain *fd);
 	void reset() {}
 
+	unsigned failure_threshold() const
+	{
+		return m_n_correct + 1;
+	}
+
 private:
 	const unsigned m_n_correct, m_n_detect, m_data_block_bits, m_log_block_bits;
+
+	/** The faults of all the chips, grouped by chip */
+	FaultBucket m_faults;
 };
 
 
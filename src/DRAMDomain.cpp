@@ -20,7 +20,6 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <cmath>
-#include <chrono>
 #include <iostream>
 #include <cassert>
 
@@ -36,12 +35,11 @@ DRAMDomain::DRAMDomain(GroupDomain *group, const std::string &name, unsigned id,
     , parent(*group)
     , n_faults({0, 0}), n_class_faults({{0, 0}}), n_tsv_faults({0, 0})
 	, FIT_rate({{0., 0.}})
+	, m_dirty(true), m_repaired({0, 0})
+	, gen(id, RandomStream::FAULT_LOCATIONS), time_gen(id, RandomStream::FAULT_TIMES)
 	, chip_in_rank(id)
     , weibull_shape(1. / weibull_shape_parameter)
 {
-	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-	gen.seed(seed);
-
 	m_size[Bits]  = bitwidth;
 	m_size[Cols]  = cols;
 	m_size[Rows]  = rows;
@@ -154,18 +152,22 @@ void DRAMDomain::dumpState()
 
 void DRAMDomain::scrub()
 {
-	// delete all transient faults
-	for (auto it = m_innerRanges.begin(); it != m_innerRanges.end(); )
-	{
-		FaultRange *fr = *it;
-		if (fr->transient && fr->transient_remove)
-		{
-			it = m_innerRanges.erase(it);
-			delete fr;
-		}
-		else
-			it++;
-	}
+	// remove all transient faults, their memory is reclaimed at the end of the simulation
+	const size_t n_ranges = m_innerRanges.size();
+	m_innerRanges.remove_if([this] (size_t i) {
+		if (!m_innerRanges.transient(i) || !m_innerRanges[i]->transient_remove)
+			return false;
+
+		parent.fault_removed(chip_in_rank, m_innerRanges[i]);
+		return true;
+	});
+
+	if (m_innerRanges.size() == n_ranges)
+		return;
+
+	// keep the outer ranges up to date without a repair, which the group may skip
+	m_dirty = true;
+	m_outerRanges.remove_if([this] (size_t i) { return m_outerRanges.transient(i) && m_outerRanges[i]->transient_remove; });
 }
 
 FaultRange *DRAMDomain::genRandomRange(fault_class_t faultClass, bool transient)
@@ -266,7 +268,17 @@ FaultRange *DRAMDomain::genRandomRange(bool rank, bool bank, bool row, bool col,
 	}
 
 
-	return new FaultRange(this, address, wildcard_mask, isTSV, transient, max_faults);
+	return parent.arena().make<FaultRange>(this, address, wildcard_mask, isTSV, transient, max_faults);
+}
+
+void DRAMDomain::merge(const FaultDomain &other)
+{
+	const DRAMDomain &chip = dynamic_cast<const DRAMDomain &>(other);
+
+	for (int i = 0; i < DRAM_MAX; i++)
+		n_class_faults[i] += chip.n_class_faults[i];
+
+	n_tsv_faults += chip.n_tsv_faults;
 }
 
 void DRAMDomain::printStats(uint64_t max_time [[gnu::unused]])
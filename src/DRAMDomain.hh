@@ -29,6 +29,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "FaultDomain.hh"
 #include "GroupDomain.hh"
+#include "FaultStore.hh"
+#include "RandomStream.hh"
 
 class FaultRange;
 
@@ -48,9 +50,14 @@ protected:
 
 	struct fault_param { double transient, permanent; } FIT_rate[DRAM_MAX];
 
-	std::list<FaultRange *> m_innerRanges, m_outerRanges;
+	FaultStore m_innerRanges, m_outerRanges;
 
-	mutable std::mt19937_64 gen;
+	/** Whether the faults changed since the last repair, otherwise m_outerRanges and m_repaired are its results */
+	bool m_dirty;
+	failures_t m_repaired;
+
+	/** Random streams for fault locations and fault arrival times */
+	mutable RandomStream gen, time_gen;
 	std::weibull_distribution<double> time_dist;
 
 	unsigned chip_in_rank;
@@ -70,44 +77,96 @@ public:
 	}
 
 	inline
-	void reset()
+	void seed(uint64_t global_seed, uint64_t sim_index)
 	{
-		for (FaultRange *fr: m_innerRanges)
-			delete fr;
+		gen.seed(global_seed, sim_index);
+		time_gen.seed(global_seed, sim_index);
 
+		FaultDomain::seed(global_seed, sim_index);
+	}
+
+	inline
+	void seed_clone(uint64_t clone_seed, uint64_t sim_index)
+	{
+		gen.seed(clone_seed, sim_index);
+		time_gen.seed(clone_seed, sim_index);
+
+		FaultDomain::seed_clone(clone_seed, sim_index);
+	}
+
+	/** Forget the faults of the simulation, which are freed with the group's arena */
+	inline
+	void reset()
+	{
 		m_outerRanges.clear();
 		m_innerRanges.clear();
 		n_faults = {0, 0};
+		m_dirty = true;
+
+		FaultDomain::reset();
 	}
 
+	/** Copy the faults of the chip, to later restore the state of a simulation in progress */
 	inline
-	std::list<FaultRange *> &getRanges()
+	void save_faults(std::list<FaultRange> &faults, faults_t &count) const
+	{
+		faults.clear();
+		for (FaultRange *fr: m_innerRanges)
+			faults.push_back(*fr);
+		count = n_faults;
+	}
+
+	inline
+	void restore_faults(const std::list<FaultRange> &faults, const faults_t &count)
+	{
+		m_innerRanges.clear();
+		parent.faults_cleared(chip_in_rank);
+		for (const FaultRange &fr: faults)
+		{
+			FaultRange *copy = parent.arena().make<FaultRange>(fr);
+			m_innerRanges.push_back(copy, maskClass(fr.fWildMask));
+			parent.fault_inserted(chip_in_rank, copy);
+		}
+
+		m_outerRanges = m_innerRanges;
+		n_faults = count;
+		m_dirty = true;
+	}
+
+	inline
+	FaultStore &getRanges()
 	{
 		return m_outerRanges;
 	}
 
+	/** Repair the faults of the chip, only recomputed when they changed since the last repair */
 	inline
 	virtual failures_t repair()
 	{
+		if (!m_dirty)
+			return m_repaired;
+
 		// TODO: repair() does the transformation of inner -> outer ranges for now,
 		// this is probably poor design. Instead we should apply repair on inside addresses
 		// and then transform to outside addresses.
-		m_outerRanges.clear();
-		std::copy(m_innerRanges.begin(), m_innerRanges.end(),
-				  std::back_inserter(m_outerRanges));
+		m_outerRanges = m_innerRanges;
 
-		return FaultDomain::repair();
+		m_repaired = FaultDomain::repair();
+		m_dirty = false;
+		return m_repaired;
 	}
 
 	inline
 	void insertFault(FaultRange *fr)
 	{
-		m_innerRanges.push_back(fr);
-		// TODO: remap columns from pre-onDIE ECC -> post onDIE ECC
-		m_outerRanges.push_back(fr);
-
 		fault_class_t cls = maskClass(fr->fWildMask);
 
+		m_innerRanges.push_back(fr, cls);
+		// TODO: remap columns from pre-onDIE ECC -> post onDIE ECC
+		m_outerRanges.push_back(fr, cls);
+		parent.fault_inserted(chip_in_rank, fr);
+		m_dirty = true;
+
 		if (fr->transient)
 		{
 			n_faults.transient++;
@@ -141,6 +200,7 @@ public:
 	void scrub();
 	void dumpState();
 	void printStats(uint64_t max_time);
+	void merge(const FaultDomain &other);
 
 
 	fault_class_t maskClass(uint64_t mask);
@@ -148,12 +208,26 @@ public:
 
 	FaultRange *genRandomRange(fault_class_t faultClass, bool transient);
 
+	/** Expected number of faults per second of a given class, which is the rate of their arrival when exponential() */
+	inline
+	double fault_rate(fault_class_t faultClass, bool transient) const
+	{
+		return (transient ? FIT_rate[faultClass].transient : FIT_rate[faultClass].permanent) / 3600e9;
+	}
+
+	/** Whether fault arrivals are a Poisson process, i.e. the inter-arrival times are exponentially distributed */
+	inline
+	bool exponential() const
+	{
+		return weibull_shape == 1.;
+	}
+
 	inline
 	double next_fault_event(fault_class_t faultClass, bool transient) const
 	{
 		// with default parameter weibull shape (= 1.) this is an exponential distribution with expected value weibull_scale
 		double weibull_scale = 3600e9 / (transient ? FIT_rate[faultClass].transient : FIT_rate[faultClass].permanent);
-		return std::weibull_distribution<double>(weibull_shape, weibull_scale)(gen);
+		return std::weibull_distribution<double>(weibull_shape, weibull_scale)(time_gen);
 	}
 
 
@@ -163,6 +237,9 @@ public:
 	template <enum DramField F>
 	inline uint32_t getLog() const { return m_logsize[F]; }
 
+	template <enum DramField F>
+	inline uint64_t getMask() const { return m_mask[F]; }
+
 	template <enum DramField F>
 	inline uint32_t has(const uint64_t wildmask) const { return m_mask[F] != 0 && (wildmask & m_mask[F]) != m_mask[F]; }
 
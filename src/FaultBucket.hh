@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FAULTBUCKET_HH_
+#define FAULTBUCKET_HH_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/** Faults sorted to count the groups (e.g. chips or codeword symbols) that have faults intersecting a given fault
+ *
+ * Faults whose key bits (typically rank, bank and row) are all fixed are sorted by these bits, while the faults that have
+ * any key bit wildcarded are kept in a separate, short list. A query whose key bits are fixed then only tests the faults
+ * with its key, found by binary search, and the wildcard list. Each group is counted once per query, by stamping it with
+ * the query number rather than clearing a set of groups.
+ */
+class FaultBucket
+{
+public:
+	/** A fault: its range, the group it belongs to, and an index for the caller */
+	struct fault_t
+	{
+		uint64_t addr, mask;
+		uint32_t group, index;
+	};
+
+private:
+	/** Order of faults by their key bits */
+	struct key_less
+	{
+		uint64_t key_mask;
+		inline bool operator()(const fault_t &a, const fault_t &b) const { return (a.addr & key_mask) < (b.addr & key_mask); }
+	};
+
+	uint64_t m_key_mask;
+	std::vector<fault_t> m_keyed, m_wild;
+	/** Last query in which each group was counted */
+	std::vector<uint32_t> m_seen;
+	uint32_t m_query;
+
+public:
+	FaultBucket() : m_key_mask(0), m_keyed(), m_wild(), m_seen(), m_query(0) {}
+
+	/** Empty the bucket, for faults of n_groups groups keyed on the address bits of key_mask */
+	inline
+	void clear(uint64_t key_mask, size_t n_groups)
+	{
+		m_key_mask = key_mask;
+		m_keyed.clear();
+		m_wild.clear();
+		m_seen.assign(n_groups, m_query);
+	}
+
+	inline
+	void push_back(const fault_t &fault)
+	{
+		(fault.mask & m_key_mask ? m_wild : m_keyed).push_back(fault);
+	}
+
+	/** Sort the faults by key, once all of them are added and before any query */
+	inline
+	void sort()
+	{
+		std::sort(m_keyed.begin(), m_keyed.end(), key_less{m_key_mask});
+	}
+
+	/** The faults with a fixed key, sorted, and the others */
+	inline const std::vector<fault_t> &keyed() const { return m_keyed; }
+	inline const std::vector<fault_t> &wild() const { return m_wild; }
+
+	/** Number of groups other than the fault's own that have a fault intersecting it */
+	inline
+	uint32_t intersecting_groups(const fault_t &fault)
+	{
+		uint32_t n_groups = 0;
+		m_query++;
+
+		auto visit = [&] (const fault_t &other) {
+			if (other.group != fault.group && m_seen[other.group] != m_query
+					&& ((fault.addr ^ other.addr) & ~(fault.mask | other.mask)) == 0)
+			{
+				m_seen[other.group] = m_query;
+				n_groups++;
+			}
+		};
+
+		if (fault.mask & m_key_mask)
+			for (const fault_t &other: m_keyed)
+				visit(other);
+		else
+		{
+			auto range = std::equal_range(m_keyed.begin(), m_keyed.end(), fault, key_less{m_key_mask});
+			for (auto other = range.first; other != range.second; ++other)
+				visit(*other);
+		}
+
+		for (const fault_t &other: m_wild)
+			visit(other);
+
+		return n_groups;
+	}
+};
+
+#endif /* FAULTBUCKET_HH_ */
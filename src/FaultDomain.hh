@@ -99,6 +99,20 @@ public:
 		return errors;
 	}
 
+	/** select the random streams of the simulation sim_index, before each sim run */
+	virtual void seed(uint64_t global_seed, uint64_t sim_index)
+	{
+		for (std::shared_ptr<RepairScheme> rs: m_repairSchemes)
+			rs->seed(global_seed, sim_index);
+	}
+
+	/** select the random streams of a clone of the simulation sim_index, when splitting it */
+	virtual void seed_clone(uint64_t clone_seed, uint64_t sim_index)
+	{
+		for (std::shared_ptr<RepairScheme> rs: m_repairSchemes)
+			rs->seed_clone(clone_seed, sim_index);
+	}
+
 	/** reset after each sim run */
 	virtual void reset()
 	{
@@ -112,6 +126,9 @@ public:
 			rs->printStats();
 	}
 
+	/** Accumulate the cross-simulation statistics of an identical domain, e.g. simulated by another thread */
+	virtual void merge(const FaultDomain &other [[gnu::unused]]) {}
+
 	virtual void scrub() = 0;
 	virtual void dumpState() {}
 };
@@ -0,0 +1,114 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FAULTINDEX_HH_
+#define FAULTINDEX_HH_
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "FaultStore.hh"
+
+/** Spatial index over the faults of all the chips of a module
+ *
+ * Faults whose key bits (typically rank, bank and row) are all fixed are hashed by these bits, while the faults that
+ * have any key bit wildcarded (column, bank, rank faults) are kept in a separate, short list. A query whose key bits are
+ * fixed then only needs to test the faults of its own bucket and the wildcard list. Entries are (chip, fault index)
+ * pairs in increasing order, so that candidates are visited in the same order as a scan of the chips' fault stores.
+ */
+class FaultIndex
+{
+	typedef std::pair<uint32_t, uint32_t> entry_t;
+
+	uint64_t m_key_mask;
+	std::vector<const FaultStore *> m_chips;
+	std::unordered_map<uint64_t, std::vector<entry_t>> m_buckets;
+	std::vector<entry_t> m_wild;
+
+	/** First candidate of chip at or after index from in the sorted entries that intersects (address, wildmask) */
+	inline
+	size_t first_in(const std::vector<entry_t> &entries, uint32_t chip, size_t from, size_t until,
+					uint64_t address, uint64_t wildmask) const
+	{
+		const FaultStore &faults = *m_chips[chip];
+		for (auto it = std::lower_bound(entries.begin(), entries.end(), entry_t(chip, from));
+				it != entries.end() && it->first == chip && it->second < until; ++it)
+			if (faults.intersects(it->second, address, wildmask))
+				return it->second;
+
+		return until;
+	}
+
+public:
+	FaultIndex() : m_key_mask(0), m_chips(), m_buckets(), m_wild() {}
+
+	/** Index the faults of the given chips, keyed on the address bits of key_mask */
+	inline
+	void build(const std::vector<const FaultStore *> &chips, uint64_t key_mask)
+	{
+		clear();
+		m_key_mask = key_mask;
+		m_chips = chips;
+
+		for (uint32_t chip = 0; chip < m_chips.size(); chip++)
+		{
+			const FaultStore &faults = *m_chips[chip];
+			for (uint32_t i = 0; i < faults.size(); i++)
+				if (faults.mask(i) & m_key_mask)
+					m_wild.emplace_back(chip, i);
+				else
+					m_buckets[faults.addr(i) & m_key_mask].emplace_back(chip, i);
+		}
+	}
+
+	inline
+	void clear()
+	{
+		m_chips.clear();
+		m_buckets.clear();
+		m_wild.clear();
+	}
+
+	/** Index of the first fault of chip at or after from that intersects (address, wildmask), or the chip's number of faults
+	 *
+	 * Identical to m_chips[chip]->next_intersecting(from, address, wildmask), which is used when the query wildcards key bits.
+	 */
+	inline
+	size_t next_intersecting(uint32_t chip, size_t from, uint64_t address, uint64_t wildmask) const
+	{
+		const FaultStore &faults = *m_chips[chip];
+		if (wildmask & m_key_mask)
+			return faults.next_intersecting(from, address, wildmask);
+
+		size_t found = faults.size();
+		auto bucket = m_buckets.find(address & m_key_mask);
+		if (bucket != m_buckets.end())
+			found = first_in(bucket->second, chip, from, found, address, wildmask);
+
+		return first_in(m_wild, chip, from, found, address, wildmask);
+	}
+};
+
+#endif /* FAULTINDEX_HH_ */
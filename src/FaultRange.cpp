@@ -80,17 +80,33 @@ void FaultIntersection::intersection(const FaultIntersection &fr)
 	fWildMask &= fr.fWildMask;
 
 	transient_remove = transient = transient || fr.transient;
-	std::copy(fr.intersecting.begin(), fr.intersecting.end(), std::back_inserter(intersecting));
+	for (FaultRange *fault: fr)
+		add(fault);
 
 	// To enable the zero-FaultIntersection to be intersected successfully as left-hand side
 	if (m_pDRAM == nullptr)
 		m_pDRAM = fr.m_pDRAM;
 }
 
+void FaultIntersection::add(FaultRange *fault)
+{
+	if (m_n_faults == INLINE_FAULTS)
+		m_spilled = new std::vector<FaultRange*>(m_inline, m_inline + INLINE_FAULTS);
+
+	if (m_spilled)
+		m_spilled->push_back(fault);
+	else
+		m_inline[m_n_faults] = fault;
+	m_n_faults++;
+
+	for (uint64_t bits = fault->fWildMask & 0xff; bits; bits &= bits - 1)
+		m_wild_bits[__builtin_ctzll(bits)]++;
+}
+
 std::string FaultIntersection::toString()
 {
 	std::ostringstream build;
 	build << FaultRange::toString();
-	build << " intersection of " << intersecting.size() << " faults";
+	build << " intersection of " << m_n_faults << " faults";
 	return build.str();
 }
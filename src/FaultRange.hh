@@ -40,14 +40,15 @@ public:
 	DRAMDomain *m_pDRAM;
 
 	uint64_t fAddr, fWildMask; // address of faulty range, and bit positions that are wildcards (all values)
-	bool transient;
-	bool TSV;
 
 	uint64_t max_faults;
 
 	uint64_t touched;
 	uint64_t fault_mode;
 
+	// flags last, so that they pack together and derived classes can use the padding after them
+	bool transient;
+	bool TSV;
 	bool transient_remove;
 
 	FaultRange(DRAMDomain *pDRAM);
@@ -55,8 +56,8 @@ public:
 	inline
 	FaultRange(DRAMDomain *pDRAM, uint64_t addr, uint64_t mask, bool is_tsv, bool is_transient, uint64_t nbits)
 		: m_pDRAM(pDRAM)
-		, fAddr(addr), fWildMask(mask), transient(is_transient), TSV(is_tsv), max_faults(nbits)
-	    , touched(0), fault_mode(0), transient_remove(true)
+		, fAddr(addr), fWildMask(mask), max_faults(nbits)
+	    , touched(0), fault_mode(0), transient(is_transient), TSV(is_tsv), transient_remove(true)
 	{
 	}
 
@@ -83,26 +84,48 @@ public:
 	bool scrub_candidate() {
 		return transient && transient_remove;
 	}
-
-private:
-	// Chip location of this fault range.
-	uint32_t Chip;
-
-	std::list<FaultRange> m_children;    // 'smaller' ranges contained within this one
 };
 
 
+/** Intersection of faults, which keeps track of the faults that intersect
+ *
+ * The intersecting faults are stored inline up to INLINE_FAULTS, only intersections of more faults (e.g. from a single
+ * chip with in-DRAM ECC) allocate memory for them. This keeps the FaultIntersection within two cache lines.
+ */
 class FaultIntersection: public FaultRange
 {
 private:
-	std::vector<FaultRange*> intersecting;
+	static constexpr unsigned INLINE_FAULTS = 5;
+
+	enum : uint8_t { CORRECTED = 0, UNCORRECTED, UNDETECTED } outcome;
+
+	uint32_t m_n_faults;
+	/** Number of intersecting faults with each of the 8 lowest bits set in their wildcard mask, for bit_count_sum() */
+	uint8_t m_wild_bits[8];
+	/** All intersecting faults, once there are more than INLINE_FAULTS */
+	std::vector<FaultRange*> *m_spilled;
+	FaultRange *m_inline[INLINE_FAULTS];
 
-	enum { CORRECTED = 0, UNCORRECTED, UNDETECTED } outcome;
+	inline FaultRange **begin() { return m_spilled ? m_spilled->data() : m_inline; }
+	inline FaultRange **end() { return begin() + m_n_faults; }
+	inline FaultRange *const *begin() const { return m_spilled ? m_spilled->data() : m_inline; }
+	inline FaultRange *const *end() const { return begin() + m_n_faults; }
+
+	void add(FaultRange *fault);
+
+	inline
+	void copy_faults(const FaultIntersection &other)
+	{
+		std::copy(other.m_wild_bits, other.m_wild_bits + 8, m_wild_bits);
+		if (!other.m_spilled)
+			std::copy(other.m_inline, other.m_inline + other.m_n_faults, m_inline);
+	}
 
 public:
 	// The intersection of 0 faults
 	FaultIntersection() :
-		FaultRange(nullptr, 0ULL, ~0ULL, false, false, 0), intersecting(), outcome(CORRECTED)
+		FaultRange(nullptr, 0ULL, ~0ULL, false, false, 0)
+		, outcome(CORRECTED), m_n_faults(0), m_wild_bits(), m_spilled(nullptr)
 	{
 	}
 
@@ -110,20 +133,63 @@ public:
 	FaultIntersection(FaultRange *fault, uint64_t min_mask):
 		FaultRange(fault->m_pDRAM, fault->fAddr & ~min_mask, fault->fWildMask | min_mask,
 				   fault->TSV, fault->transient, fault->max_faults)
-		, intersecting({fault})
-		, outcome(UNDETECTED)
+		, outcome(UNDETECTED), m_n_faults(0), m_wild_bits(), m_spilled(nullptr)
 	{
+		add(fault);
 	}
 
-	inline ~FaultIntersection() { intersecting.clear(); }
+	inline
+	FaultIntersection(const FaultIntersection &other)
+		: FaultRange(other)
+		, outcome(other.outcome), m_n_faults(other.m_n_faults)
+		, m_spilled(other.m_spilled ? new std::vector<FaultRange*>(*other.m_spilled) : nullptr)
+	{
+		copy_faults(other);
+	}
+
+	inline
+	FaultIntersection(FaultIntersection &&other)
+		: FaultRange(other)
+		, outcome(other.outcome), m_n_faults(other.m_n_faults), m_spilled(other.m_spilled)
+	{
+		copy_faults(other);
+		other.m_spilled = nullptr;
+	}
+
+	inline
+	FaultIntersection& operator=(FaultIntersection other)
+	{
+		FaultRange::operator=(other);
+		outcome = other.outcome;
+		m_n_faults = other.m_n_faults;
+		copy_faults(other);
+		std::swap(m_spilled, other.m_spilled);
+		return *this;
+	}
+
+	inline ~FaultIntersection() { delete m_spilled; }
 
 	void intersection(const FaultIntersection &fr);
 
+	/** Intersect with a single fault at the granularity of min_mask, like intersection(FaultIntersection(fault, min_mask)) */
+	inline
+	void intersection(FaultRange *fault, uint64_t min_mask)
+	{
+		fAddr = (fAddr & ~fWildMask) | (fault->fAddr & ~(fault->fWildMask | min_mask));
+		fWildMask &= fault->fWildMask | min_mask;
+
+		transient_remove = transient = transient || fault->transient;
+		add(fault);
+
+		if (m_pDRAM == nullptr)
+			m_pDRAM = fault->m_pDRAM;
+	}
+
 	// Each FaultRange represents chip with intersecting errors
 	inline
 	size_t chip_count()
 	{
-		return intersecting.size();
+		return m_n_faults;
 	}
 
 	/**
@@ -135,45 +201,17 @@ public:
 	inline
 	size_t bit_count_sum(size_t word_mask)
 	{
-		size_t wrong_bits = 0;
-		for (auto &fr: intersecting)
-			wrong_bits += __builtin_popcount(fr->fWildMask & word_mask) + 1;
+		size_t wrong_bits = m_n_faults;
+		if (word_mask < 0x100 && m_n_faults < 0x100)
+			for (; word_mask; word_mask &= word_mask - 1)
+				wrong_bits += m_wild_bits[__builtin_ctzll(word_mask)];
+		else
+			for (FaultRange *fr: *this)
+				wrong_bits += __builtin_popcount(fr->fWildMask & word_mask);
 
 		return wrong_bits;
 	}
 
-	/**
-	 * Returns the number of wrong bits in the intersecting errors.
-	 *
-	 * Assumes that all errors happen in the same chip, so this function aggregates the fault ranges together and counts
-	 * the resulting number of errors in the range defined by the FaultIntersection’s parameters.
-	 */
-	inline
-	size_t bit_count_aggregate(size_t word_size)
-	{
-		std::sort(intersecting.begin(), intersecting.end(), [] (FaultRange *a, FaultRange *b) {
-			return std::make_pair(a->fAddr, a->fAddr | a->fWildMask) < std::make_pair(b->fAddr, b->fAddr | b->fWildMask);
-		});
-
-		size_t count = 0, from = fAddr, until = std::min(from + word_size, (fAddr | fWildMask) + 1);
-		for (auto &fr: intersecting)
-		{
-			// Check the mask is “full”, i.e. a number of the form 2^m - 1, or 0b000..0011..11
-			// If it’s not, some inclusion-exclusion computation needs to be done instead of the simple range maths.
-			assert((1UL << __builtin_popcount(fr->fWildMask)) - 1 == fr->fWildMask);
-
-			size_t s = std::max(from, fr->fAddr);
-			size_t e = std::min(until, (fr->fAddr | fr->fWildMask) + 1);
-
-			count += e - s;
-
-			from = s;
-			until = e;
-		}
-
-		return count;
-	}
-
 	inline
 	void mark_corrected()
 	{
@@ -186,7 +224,7 @@ public:
 		outcome = UNCORRECTED;
 
 		transient_remove = false;
-		for (auto &fr: intersecting)
+		for (FaultRange *fr: *this)
 			fr->mark_uncorrectable();
 	}
 
@@ -196,7 +234,7 @@ public:
 		outcome = UNDETECTED;
 
 		transient_remove = false;
-		for (auto &fr: intersecting)
+		for (FaultRange *fr: *this)
 			fr->mark_uncorrectable();
 	}
 
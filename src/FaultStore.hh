@@ -0,0 +1,156 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FAULTSTORE_HH_
+#define FAULTSTORE_HH_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "dram_common.hh"
+#include "FaultRange.hh"
+#include "IntersectKernel.hh"
+
+/** Contiguous storage for the faults of a chip
+ *
+ * The fields needed to search faults (address, wildcard mask, fault class, flags) are kept in parallel arrays, so that
+ * scans do not need to dereference the FaultRange objects. Iterating yields the FaultRange pointers in insertion order.
+ */
+class FaultStore
+{
+public:
+	enum flags_t : uint8_t { TRANSIENT = 1, TSV = 2 };
+
+	typedef std::vector<FaultRange *>::const_iterator const_iterator;
+
+	inline size_t size() const { return m_ranges.size(); }
+	inline bool empty() const { return m_ranges.empty(); }
+
+	inline const_iterator begin() const { return m_ranges.cbegin(); }
+	inline const_iterator end() const { return m_ranges.cend(); }
+
+	inline FaultRange *operator[](size_t i) const { return m_ranges[i]; }
+	inline uint64_t addr(size_t i) const { return m_addr[i]; }
+	inline uint64_t mask(size_t i) const { return m_mask[i]; }
+	inline fault_class_t fault_class(size_t i) const { return static_cast<fault_class_t>(m_class[i]); }
+	inline bool transient(size_t i) const { return m_flags[i] & TRANSIENT; }
+
+	inline const uint64_t *addrs() const { return m_addr.data(); }
+	inline const uint64_t *masks() const { return m_mask.data(); }
+
+	inline
+	void push_back(FaultRange *fr, fault_class_t cls)
+	{
+		m_ranges.push_back(fr);
+		m_addr.push_back(fr->fAddr);
+		m_mask.push_back(fr->fWildMask);
+		m_class.push_back(cls);
+		m_flags.push_back((fr->transient ? TRANSIENT : 0) | (fr->TSV ? TSV : 0));
+	}
+
+	inline
+	void clear()
+	{
+		m_ranges.clear();
+		m_addr.clear();
+		m_mask.clear();
+		m_class.clear();
+		m_flags.clear();
+	}
+
+	/** Whether fault i intersects the range (address, mask) */
+	inline
+	bool intersects(size_t i, uint64_t address, uint64_t wildmask) const
+	{
+		return ((m_addr[i] ^ address) & ~(m_mask[i] | wildmask)) == 0;
+	}
+
+	/** Index of the first fault at or after from that intersects the range (address, mask), or size() if there are none
+	 *
+	 * Short stores are scanned inline, longer ones in batches of 64 faults with the vectorised intersect_batch kernel.
+	 */
+	inline
+	size_t next_intersecting(size_t from, uint64_t address, uint64_t wildmask) const
+	{
+		const size_t n = size();
+		if (n - from < SCALAR_SCAN)
+		{
+			while (from < n && !intersects(from, address, wildmask))
+				from++;
+			return from;
+		}
+
+		for (; from < n; from += 64)
+		{
+			size_t batch = n - from < 64 ? n - from : 64;
+			uint64_t hits = intersect_batch(m_addr.data() + from, m_mask.data() + from, batch, address, wildmask);
+			if (hits)
+				return from + __builtin_ctzll(hits);
+		}
+		return n;
+	}
+
+	/** Index of the first fault that intersects the range (address, mask), or size() if there are none */
+	inline
+	size_t find_intersecting(uint64_t address, uint64_t wildmask) const
+	{
+		return next_intersecting(0, address, wildmask);
+	}
+
+	/** Remove the faults at the indexes for which pred(index) is true, keeping the order of the others */
+	template<typename Pred>
+	void remove_if(Pred pred)
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i < size(); i++)
+		{
+			if (pred(i))
+				continue;
+
+			if (kept != i)
+			{
+				m_ranges[kept] = m_ranges[i];
+				m_addr[kept] = m_addr[i];
+				m_mask[kept] = m_mask[i];
+				m_class[kept] = m_class[i];
+				m_flags[kept] = m_flags[i];
+			}
+			kept++;
+		}
+
+		m_ranges.resize(kept);
+		m_addr.resize(kept);
+		m_mask.resize(kept);
+		m_class.resize(kept);
+		m_flags.resize(kept);
+	}
+
+private:
+	/** Below this many faults a plain loop is cheaper than calling the batch kernel */
+	static constexpr size_t SCALAR_SCAN = 8;
+
+	std::vector<FaultRange *> m_ranges;
+	std::vector<uint64_t> m_addr, m_mask;
+	std::vector<uint8_t> m_class, m_flags;
+};
+
+#endif /* FAULTSTORE_HH_ */
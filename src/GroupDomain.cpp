@@ -20,13 +20,24 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "GroupDomain.hh"
+#include "DRAMDomain.hh"
 #include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <set>
 #include <stdlib.h>
 
 GroupDomain::GroupDomain(const std::string& name)
 	: FaultDomain(name)
+	, m_children(), m_arena(), m_occupancy(), m_child_repairs(false)
 	, stat_n_simulations(0), stat_total_failures(0)
-	, stat_n_failures({0, 0}), n_errors({0, 0})
+	, stat_n_failures({0, 0})
+	, stat_weighted_failures(0.), stat_weighted_undetected(0.), stat_weighted_uncorrected(0.)
+	, stat_squared_failures(0.), stat_squared_undetected(0.), stat_squared_uncorrected(0.)
+	, stat_expected_failures(0.)
+	, n_errors({0, 0}), sim_failed(false), sim_n_failures({0, 0})
+	, sim_weighted_failures(0.), sim_weighted_undetected(0.), sim_weighted_uncorrected(0.)
 {
 }
 
@@ -44,11 +55,44 @@ void GroupDomain::reset()
 	n_errors = {0, 0};
 
 	stat_n_simulations++;
+	stat_total_failures += sim_failed;
+	stat_n_failures += sim_n_failures;
+	sim_failed = false;
+	sim_n_failures = {0, 0};
+
+	// the variance is estimated over whole simulations, including all their branches
+	stat_weighted_failures += sim_weighted_failures;
+	stat_weighted_undetected += sim_weighted_undetected;
+	stat_weighted_uncorrected += sim_weighted_uncorrected;
+	stat_squared_failures += sim_weighted_failures * sim_weighted_failures;
+	stat_squared_undetected += sim_weighted_undetected * sim_weighted_undetected;
+	stat_squared_uncorrected += sim_weighted_uncorrected * sim_weighted_uncorrected;
+	sim_weighted_failures = sim_weighted_undetected = sim_weighted_uncorrected = 0.;
 
 	for (FaultDomain *fd: m_children)
 		fd->reset();
+	m_occupancy.clear();
 
 	FaultDomain::reset();
+
+	// all faults and errors of the simulation are gone
+	m_arena.release();
+}
+
+void GroupDomain::seed(uint64_t global_seed, uint64_t sim_index)
+{
+	for (FaultDomain *fd: m_children)
+		fd->seed(global_seed, sim_index);
+
+	FaultDomain::seed(global_seed, sim_index);
+}
+
+void GroupDomain::seed_clone(uint64_t clone_seed, uint64_t sim_index)
+{
+	for (FaultDomain *fd: m_children)
+		fd->seed_clone(clone_seed, sim_index);
+
+	FaultDomain::seed_clone(clone_seed, sim_index);
 }
 
 faults_t GroupDomain::getFaultCount()
@@ -61,6 +105,124 @@ faults_t GroupDomain::getFaultCount()
 	return n_faults;
 }
 
+unsigned GroupDomain::failure_threshold()
+{
+	// A group-level error requires all repair schemes to fail
+	unsigned threshold = 1;
+	for (std::shared_ptr<RepairScheme> rs: m_repairSchemes)
+		threshold = std::max(threshold, rs->failure_threshold());
+
+	return threshold;
+}
+
+/** The occupancy slot of a fault: its (rank, bank), its rank if it spans all banks, or the whole chip if it spans all ranks */
+static size_t occupancy_slot(const ChipOccupancy &occupancy, const FaultRange *fr)
+{
+	const DRAMDomain *chip = fr->m_pDRAM;
+
+	if (!chip->has<Ranks>(fr->fWildMask) && chip->getNum<Ranks>() > 1)
+		return occupancy.all_slot();
+	else if (!chip->has<Banks>(fr->fWildMask) && chip->getNum<Banks>() > 1)
+		return occupancy.rank_slot(chip->get<Ranks>(fr->fAddr));
+	else
+		return occupancy.bank_slot(chip->get<Ranks>(fr->fAddr), chip->get<Banks>(fr->fAddr));
+}
+
+void GroupDomain::fault_inserted(unsigned chip, const FaultRange *fr)
+{
+	if (!tracks_occupancy())
+		return;
+
+	if (m_occupancy.empty())
+	{
+		const DRAMDomain *dram = fr->m_pDRAM;
+		m_occupancy.resize(m_children.size(), dram->getNum<Ranks>(), dram->getNum<Banks>());
+	}
+
+	m_occupancy.add(occupancy_slot(m_occupancy, fr), chip);
+}
+
+void GroupDomain::fault_removed(unsigned chip, const FaultRange *fr)
+{
+	if (tracks_occupancy())
+		m_occupancy.remove(occupancy_slot(m_occupancy, fr), chip);
+}
+
+void GroupDomain::faults_cleared(unsigned chip)
+{
+	if (!m_occupancy.empty())
+		m_occupancy.clear(chip);
+}
+
+unsigned GroupDomain::danger_level()
+{
+	// the faults seen by the group are the ones inserted in the chips, unless children repairs transform them
+	if (!m_child_repairs && tracks_occupancy())
+		return m_occupancy.max_chips();
+
+	// chips with faults in each (rank, bank), or in every bank of a rank, or everywhere
+	std::map<std::pair<uint64_t, uint64_t>, unsigned> bank_chips;
+	std::map<uint64_t, unsigned> rank_chips;
+	unsigned all_chips = 0;
+
+	for (FaultDomain *fd: m_children)
+	{
+		DRAMDomain *chip = dynamic_cast<DRAMDomain *>(fd);
+
+		std::set<std::pair<uint64_t, uint64_t>> banks;
+		std::set<uint64_t> ranks;
+		bool all = false;
+
+		for (FaultRange *fr: chip->getRanges())
+			if (!chip->has<Ranks>(fr->fWildMask) && chip->getNum<Ranks>() > 1)
+				all = true;
+			else if (!chip->has<Banks>(fr->fWildMask) && chip->getNum<Banks>() > 1)
+				ranks.insert(chip->get<Ranks>(fr->fAddr));
+			else
+				banks.emplace(chip->get<Ranks>(fr->fAddr), chip->get<Banks>(fr->fAddr));
+
+		all_chips += all;
+		for (uint64_t rank: ranks)
+			rank_chips[rank] += !all;
+		for (auto &bank: banks)
+			bank_chips[bank] += !all && !ranks.count(bank.first);
+	}
+
+	unsigned level = all_chips;
+	for (auto &rank: rank_chips)
+		level = std::max(level, all_chips + rank.second);
+	for (auto &bank: bank_chips)
+		level = std::max(level, all_chips + rank_chips[bank.first.first] + bank.second);
+
+	return level;
+}
+
+void GroupDomain::save_state(snapshot_t &state) const
+{
+	state.n_errors = n_errors;
+	state.faults.resize(m_children.size());
+	state.n_faults.resize(m_children.size());
+
+	size_t pos = 0;
+	for (FaultDomain *fd: m_children)
+	{
+		dynamic_cast<DRAMDomain *>(fd)->save_faults(state.faults[pos], state.n_faults[pos]);
+		pos++;
+	}
+}
+
+void GroupDomain::restore_state(const snapshot_t &state)
+{
+	n_errors = state.n_errors;
+
+	size_t pos = 0;
+	for (FaultDomain *fd: m_children)
+	{
+		dynamic_cast<DRAMDomain *>(fd)->restore_faults(state.faults[pos], state.n_faults[pos]);
+		pos++;
+	}
+}
+
 void GroupDomain::dumpState()
 {
 	FaultDomain::dumpState();
@@ -87,8 +249,8 @@ failures_t GroupDomain::repair()
 	// Apply group-level ECC, iteratively reduce number of faults with each successive repair scheme.
 	for (std::shared_ptr<RepairScheme> rs: m_repairSchemes)
 	{
-		// TODO: would be nice to share information between repair schemes,
-		// so that a scheme can act on the outputs/results of the previous one(s)
+		// NB: schemes of a DIMM share their intersections, and act on the failures left by the previous one(s),
+		// through GroupDomain_dimm::intersecting_ranges()
 		failures_t after_repair = rs->repair(this);
 
 		// if any repair happened, dump
@@ -117,7 +279,7 @@ failures_t GroupDomain::repair()
 }
 
 
-void GroupDomain::finalize()
+void GroupDomain::finalize(double weight)
 {
 	// walk through all children and observe their error counts
 	// If 1 or more children had a fault, record a failed simulation
@@ -134,14 +296,44 @@ void GroupDomain::finalize()
 			}
 
 	if (failure)
-		stat_total_failures++;
+	{
+		sim_failed = true;
+		sim_weighted_failures += weight;
+	}
 
 	// Determine per-simulation statistics
 	if (n_errors.undetected != 0)
-		stat_n_failures.undetected++;
+	{
+		sim_n_failures.undetected = 1;
+		sim_weighted_undetected += weight;
+	}
 
 	if (n_errors.uncorrected != 0)
-		stat_n_failures.uncorrected++;
+	{
+		sim_n_failures.uncorrected = 1;
+		sim_weighted_uncorrected += weight;
+	}
+}
+
+
+void GroupDomain::merge(const FaultDomain &other)
+{
+	const GroupDomain &group = dynamic_cast<const GroupDomain &>(other);
+
+	stat_n_simulations += group.stat_n_simulations;
+	stat_total_failures += group.stat_total_failures;
+	stat_n_failures += group.stat_n_failures;
+	stat_weighted_failures += group.stat_weighted_failures;
+	stat_weighted_undetected += group.stat_weighted_undetected;
+	stat_weighted_uncorrected += group.stat_weighted_uncorrected;
+	stat_squared_failures += group.stat_squared_failures;
+	stat_squared_undetected += group.stat_squared_undetected;
+	stat_squared_uncorrected += group.stat_squared_uncorrected;
+	stat_expected_failures += group.stat_expected_failures;
+
+	auto theirs = group.m_children.cbegin();
+	for (auto mine = m_children.begin(); mine != m_children.end() && theirs != group.m_children.cend(); ++mine, ++theirs)
+		(*mine)->merge(**theirs);
 }
 
 
@@ -152,15 +344,26 @@ void GroupDomain::printStats(uint64_t sim_seconds)
 	for (FaultDomain *fd: m_children)
 		fd->printStats(sim_seconds);
 
-	// TODO: some slightly more advanced stats? At least some variability.
 	const double sim_seconds_to_FIT = 3600e9 / sim_seconds, nsim = stat_n_simulations;
 
-	double device_fail_rate = stat_total_failures / nsim;
-	double uncorrected_fail_rate = stat_n_failures.uncorrected / nsim;
-	double undetected_fail_rate = stat_n_failures.undetected / nsim;
+	double device_fail_rate = (stat_weighted_failures + stat_expected_failures) / nsim;
+	double uncorrected_fail_rate = stat_weighted_uncorrected / nsim;
+	double undetected_fail_rate = stat_weighted_undetected / nsim;
+
+	// Standard error of the mean of the weighted outcomes of the simulations
+	auto std_error = [nsim] (double sum, double sum_squares) {
+		return nsim > 1 ? std::sqrt(std::max(sum_squares / nsim - (sum / nsim) * (sum / nsim), 0.) / (nsim - 1)) : 0.;
+	};
+
+	double device_fail_err = std_error(stat_weighted_failures, stat_squared_failures);
+	double uncorrected_fail_err = std_error(stat_weighted_uncorrected, stat_squared_uncorrected);
+	double undetected_fail_err = std_error(stat_weighted_undetected, stat_squared_undetected);
 
 	std::cout << "[" << m_name << "] sims " << stat_n_simulations << " failed_sims " << stat_total_failures
 		<< " rate_raw " << device_fail_rate << " FIT_raw " << device_fail_rate * sim_seconds_to_FIT
 		<< " rate_uncorr " << uncorrected_fail_rate << " FIT_uncorr " << uncorrected_fail_rate * sim_seconds_to_FIT
-		<< " rate_undet " << undetected_fail_rate << " FIT_undet " << undetected_fail_rate * sim_seconds_to_FIT << '\n';
+		<< " rate_undet " << undetected_fail_rate << " FIT_undet " << undetected_fail_rate * sim_seconds_to_FIT
+		<< " FIT_raw_stderr " << device_fail_err * sim_seconds_to_FIT
+		<< " FIT_uncorr_stderr " << uncorrected_fail_err * sim_seconds_to_FIT
+		<< " FIT_undet_stderr " << undetected_fail_err * sim_seconds_to_FIT << '\n';
 }
@@ -28,18 +28,37 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "FaultDomain.hh"
 #include "RepairScheme.hh"
 #include "Settings.hh"
+#include "Arena.hh"
+#include "ChipOccupancy.hh"
 
 class GroupDomain : public FaultDomain
 {
 protected:
 	std::list<FaultDomain *> m_children;
 
+	/** Memory for the faults and errors of the current simulation, released when resetting */
+	Arena m_arena;
+
+	/** Chips holding faults in each rank and bank, and whether children repairs may change the faults seen by the group */
+	ChipOccupancy m_occupancy;
+	bool m_child_repairs;
+
 	// cross-simulation overall program run statistics
 	uint64_t stat_n_simulations, stat_total_failures;
 	failures_t stat_n_failures;
 
-	// per-simulation run statistics
+	// the same statistics weighted by the probability of each simulation relative to plain Monte Carlo, the sums of squared
+	// weights to estimate their variance, and the expected failures of simulations that were accounted for but not run
+	double stat_weighted_failures, stat_weighted_undetected, stat_weighted_uncorrected;
+	double stat_squared_failures, stat_squared_undetected, stat_squared_uncorrected;
+	double stat_expected_failures;
+
+	// per-simulation run statistics, weighted statistics are summed over all the branches of split simulations, while
+	// a simulation is counted once as failed if any of its branches failed
 	failures_t n_errors;
+	bool sim_failed;
+	failures_t sim_n_failures;
+	double sim_weighted_failures, sim_weighted_undetected, sim_weighted_uncorrected;
 
 	GroupDomain(const std::string& name);
 
@@ -47,11 +66,14 @@ public:
 	virtual ~GroupDomain();
 
     failures_t repair();
-    void finalize();
+    void finalize(double weight = 1.);
 	virtual void reset();
+	virtual void seed(uint64_t global_seed, uint64_t sim_index);
+	virtual void seed_clone(uint64_t clone_seed, uint64_t sim_index);
 
 	virtual void dumpState();
     void printStats(uint64_t max_time);
+	virtual void merge(const FaultDomain &other);
 
     inline void scrub()
 	{
@@ -72,6 +94,33 @@ public:
 		std::shared_ptr<RepairScheme> repair(rs);
 		for (FaultDomain *fd: m_children)
 			fd->addRepair(repair);
+
+		m_child_repairs = true;
+	}
+
+	/** Keep track of the faults of the chip at position chip in the group */
+	void fault_inserted(unsigned chip, const FaultRange *fr);
+	void fault_removed(unsigned chip, const FaultRange *fr);
+	void faults_cleared(unsigned chip);
+
+	inline
+	Arena &arena()
+	{
+		return m_arena;
+	}
+
+	/** Whether the chips holding faults are tracked, which bitmasks limit to groups of at most 64 chips */
+	inline
+	bool tracks_occupancy() const
+	{
+		return m_children.size() <= 64;
+	}
+
+	/** The chips holding faults in each rank and bank, empty if not tracked */
+	inline
+	const ChipOccupancy &occupancy() const
+	{
+		return m_occupancy;
 	}
 
 	inline
@@ -86,6 +135,37 @@ public:
 		return stat_total_failures;
 	}
 
+	/** Equivalent to finalize() then reset() on a simulation where no fault happened */
+	inline
+	void skip_fault_free()
+	{
+		stat_n_simulations++;
+	}
+
+	/** Account for simulations that are not run because they are known to have faults but no errors */
+	inline
+	void add_fault_weight(double weight)
+	{
+		stat_expected_failures += weight;
+	}
+
+	/** Minimum number of faults that may cause an error in this domain */
+	unsigned failure_threshold();
+
+	/** Maximum number of chips with faults in a same rank and bank, which measures how close the domain is to an error */
+	unsigned danger_level();
+
+	/** State of a simulation in progress: the faults of each chip and the errors so far */
+	struct snapshot_t
+	{
+		failures_t n_errors;
+		std::vector<std::list<FaultRange>> faults;
+		std::vector<faults_t> n_faults;
+	};
+
+	void save_state(snapshot_t &state) const;
+	void restore_state(const snapshot_t &state);
+
 	faults_t getFaultCount();
 	inline failures_t getErrorCount() { return n_errors; }
 };
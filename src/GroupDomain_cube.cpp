@@ -22,7 +22,6 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <iostream>
 #include <sstream>
 #include <random>
-#include <chrono>
 
 #include "DRAMDomain.hh"
 #include "ChipKillRepair_cube.hh"
@@ -39,11 +38,8 @@ GroupDomain_cube::GroupDomain_cube(const std::string& name, unsigned cube_model,
 	, cube_model(cube_model == 1 ? HORIZONTAL : VERTICAL), cube_data_tsv(burst_size / 2), enable_tsv(enable_tsv)
 	, m_cube_addr_dec_depth(cube_addr_dec_depth), cube_ecc_tsv(cube_ecc_tsv), cube_redun_tsv(cube_redun_tsv)
 	, tsv_transientFIT(0), tsv_permanentFIT(0)
-	, gen(), tsv_dist()
+	, gen(RandomStream::GROUP, RandomStream::TSV_LOCATIONS), tsv_dist()
 {
-	unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-	gen.seed(seed);
-
 	/* Total number of TSVs in each category.
 	 * Horizontal channel config, assuming 32B (256b) of data: if DDR is used, then we have 512 data bits out
 	 * Vertical channel config, assuming 16B (128b) of data: there are ~20 (16 data + maybe 4 ECC) TSVs per bank.
@@ -102,6 +98,8 @@ GroupDomain_cube* GroupDomain_cube::genModule(Settings &settings, int module_id)
 													settings.data_block_bits, settings.cube_addr_dec_depth, settings.cube_ecc_tsv,
 													settings.cube_redun_tsv, settings.enable_tsv);
 
+	stack0->arena().use_hugepages(settings.hugepages);
+
 	// Set FIT rates for TSVs, these are set at the GroupDomain level as these are common to the entire cube
 	stack0->setFIT_TSV(true, settings.tsv_fit);
 	stack0->setFIT_TSV(false, settings.tsv_fit);
@@ -26,6 +26,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "dram_common.hh"
 #include "GroupDomain.hh"
+#include "RandomStream.hh"
 
 class GroupDomain_cube : public GroupDomain
 {
@@ -63,7 +64,7 @@ class GroupDomain_cube : public GroupDomain
 	uint64_t tsv_n_faults_transientFIT_class;
 	uint64_t tsv_n_faults_permanentFIT_class;
 
-	std::mt19937_64 gen;
+	RandomStream gen;
 	std::uniform_int_distribution<uint64_t> tsv_dist;
 
 	void generateTSV(bool transient);
@@ -75,6 +76,20 @@ public:
 	static GroupDomain_cube* genModule(Settings &settings, int module_id);
 	~GroupDomain_cube();
 
+	inline
+	void seed(uint64_t global_seed, uint64_t sim_index)
+	{
+		gen.seed(global_seed, sim_index);
+		GroupDomain::seed(global_seed, sim_index);
+	}
+
+	inline
+	void seed_clone(uint64_t clone_seed, uint64_t sim_index)
+	{
+		gen.seed(clone_seed, sim_index);
+		GroupDomain::seed_clone(clone_seed, sim_index);
+	}
+
 	inline
 	void setFIT_TSV(bool isTransient_TSV, double FIT_TSV)
 	{
@@ -90,6 +105,18 @@ public:
 		return cube_model == HORIZONTAL;
 	}
 
+	inline
+	uint64_t chips() const
+	{
+		return m_chips;
+	}
+
+	inline
+	uint64_t burst_size() const
+	{
+		return m_burst_size;
+	}
+
 	void addDomain(FaultDomain *domain);
 };
 
@@ -19,8 +19,8 @@ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWIS
 THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <functional>
-#include <stack>
+#include <unordered_set>
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
@@ -41,6 +41,8 @@ GroupDomain_dimm* GroupDomain_dimm::genModule(Settings &settings, int module_id)
 	std::string mod = std::string("DIMM").append(std::to_string(module_id));
 
 	GroupDomain_dimm *dimm0 = new GroupDomain_dimm(mod, settings.chips_per_rank, settings.banks, settings.data_block_bits);
+	dimm0->arena().use_hugepages(settings.hugepages);
+	dimm0->check_skipped_repairs(settings.check_skipped_repairs);
 
 	for (uint32_t i = 0; i < settings.chips_per_rank; i++)
 	{
@@ -100,140 +102,296 @@ GroupDomain_dimm* GroupDomain_dimm::genModule(Settings &settings, int module_id)
 	return dimm0;
 }
 
-/** This functions returns the lost of fault intersections that intersect at a granularity given by symbol_size, subject to being
- * validated by the predicate.
+/** Repair the module, unless no repair scheme can fail.
  *
- * For example, to access all faults that would cause a DUE in ChipKill, and the predicate should test whether the FaultIntersection
- * contains at least 2 symbols (as they are always from different chips).
- *
- * To access all faults that would cause DUE in 3EC4ED, the predicate should test whether the number erroneous bits in the
- * FaultIntersection is at lest 3.
+ * Faults in different ranks or banks never intersect, so while fewer chips than the failure threshold have faults in a
+ * same rank and bank, the scheme with the highest threshold finds no failures and leaves none for the other schemes
+ * (see intersecting_ranges()), and the repair returns no errors. This requires the faults seen by the schemes to be the
+ * ones inserted in the chips, i.e. no in-DRAM ECC, and symbols that do not span banks. Groups too large to track which
+ * chips hold faults are always repaired.
  */
-
-std::list<FaultIntersection>& GroupDomain_dimm::intersecting_ranges(unsigned symbol_size,
-																   std::function<bool(FaultIntersection&)> predicate)
+failures_t GroupDomain_dimm::repair()
 {
-	if (m_failures_computed)
-	{
-		for (auto it = m_failures.begin(); it != m_failures.end();)
-			if (predicate(*it))
-				++it;
-			else
-				it = m_failures.erase(it);
+	m_failures.clear();
+	m_selected.clear();
+	m_failures_computed = false;
 
-		return m_failures;
+	DRAMDomain *dram = dynamic_cast<DRAMDomain*>(m_children.front());
+	// symbols are at most a burst wide
+	const uint64_t symbol_wild_mask = (1ULL << (63 - __builtin_clzll(m_burst_size))) - 1;
+	const bool skip = !m_child_repairs && tracks_occupancy() && (symbol_wild_mask & (dram->getMask<Ranks>() | dram->getMask<Banks>())) == 0
+					  && danger_level() < failure_threshold();
+
+	if (!skip)
+		return GroupDomain::repair();
+
+	if (m_check_skipped_repairs)
+	{
+		failures_t full = GroupDomain::repair();
+		if (full.any())
+		{
+			std::cerr << "ERROR: " << m_name << " skipped a repair that fails with " << full << '\n';
+			dumpState();
+			std::abort();
+		}
 	}
-	else
-		m_failures_computed = true;
 
+	return {0, 0};
+}
+
+/** Whether no set of faults can satisfy a predicate that needs at least min_chips chips, 0 meaning unknown.
+ *
+ * Faults in different ranks or banks never intersect: without enough chips with faults in a same rank and bank, there can
+ * be no failures. Only valid if symbols do not span several ranks or banks.
+ */
+bool GroupDomain_dimm::cannot_fail(unsigned symbol_size, unsigned min_chips)
+{
+	DRAMDomain *dram = dynamic_cast<DRAMDomain*>(m_children.front());
 	const uint64_t symbol_wild_mask = (1ULL << symbol_size) - 1;
 
-	// Found failures and a stack to building them through the fault range traversal
-	std::stack<FaultIntersection> error_intersection({FaultIntersection()});
+	return min_chips && (symbol_wild_mask & (dram->getMask<Ranks>() | dram->getMask<Banks>())) == 0 && danger_level() < min_chips;
+}
 
-	// Perform a DFS of intersecting fault ranges
-	auto chip = m_children.cbegin();
-	auto faultrange = dynamic_cast<DRAMDomain*>(*chip)->getRanges().cbegin();
-	std::stack<decltype(std::make_pair(chip, faultrange))> traversal({{chip, faultrange}});
+/** Build the intersection of a set of faults, as a FaultIntersection that can be marked by repair schemes */
+FaultIntersection GroupDomain_dimm::make_intersection(const intersection_cache_t &cache, const fault_set_t &set,
+													 unsigned symbol_size) const
+{
+	const uint64_t symbol_wild_mask = (1ULL << symbol_size) - 1;
 
-	while (!traversal.empty())
-	{
-		std::tie(chip, faultrange) = traversal.top();
-		traversal.pop();
+	if (set.size == 0)
+		return FaultIntersection();
 
-		// Traverse all (chip, faultrange) pairs.
-		while (chip != m_children.cend())
-		{
-			const auto end = dynamic_cast<DRAMDomain*>(*chip)->getRanges().cend();
-			for (; faultrange != end; ++faultrange)
-			{
-				FaultIntersection frInt(*faultrange, symbol_wild_mask);
+	// the intersection gets the DRAM, TSV and maximum number of faults of the fault of its last chip
+	const chip_fault_t *faults = cache.set_faults.data() + set.first;
+	FaultIntersection intersection(faults[set.size - 1].second, symbol_wild_mask);
+	intersection.transient_remove = intersection.transient;
+
+	for (uint32_t i = set.size - 1; i-- != 0;)
+		intersection.intersection(faults[i].second, symbol_wild_mask);
+
+	return intersection;
+}
+
+/** Bring the intersections cached for a symbol size up to date with the faults currently in the chips.
+ *
+ * Fault stores only append new faults and remove faults while keeping the order of the others, so comparing them to the
+ * faults known from the previous call gives the scrubbed faults, whose sets are dropped, and the new faults, whose sets
+ * are added. When most faults are new (first fault, faults rebuilt by in-DRAM ECC, restored snapshot) the sets are
+ * enumerated again instead.
+ */
+GroupDomain_dimm::intersection_cache_t &GroupDomain_dimm::update_intersections(unsigned symbol_size)
+{
+	const uint64_t symbol_wild_mask = (1ULL << symbol_size) - 1;
+
+	if (m_chip_faults.size() != m_children.size())
+	{
+		m_chip_faults.clear();
+		for (FaultDomain *fd: m_children)
+			m_chip_faults.push_back(&dynamic_cast<DRAMDomain*>(fd)->getRanges());
+	}
+	const std::vector<const FaultStore *> &chips = m_chip_faults;
+	intersection_cache_t &cache = m_intersections;
+	if (cache.symbol_size != static_cast<int>(symbol_size))
+	{
+		cache.clear();
+		cache.symbol_size = symbol_size;
+	}
 
-				assert( (frInt.fAddr & frInt.fWildMask) == 0 );
+	std::unordered_set<FaultRange *> removed;
+	std::vector<chip_fault_t> added;
+	size_t kept = 0;
 
-				// check if the fault range *faultrange intersects the previous set of intersecting fault ranges
-				if (frInt.intersects(&error_intersection.top()))
-					frInt.intersection(error_intersection.top());
+	if (cache.known_faults.size() == chips.size())
+		for (uint32_t chip = 0; chip < chips.size(); chip++)
+		{
+			const FaultStore &faults = *chips[chip];
+			size_t i = 0;
+			for (FaultRange *fr: cache.known_faults[chip])
+				if (i < faults.size() && faults[i] == fr)
+					i++;
 				else
-					// no intersection, move on to the next fault range in this chip
-					continue;
+					removed.insert(fr);
 
-				// save the cumulated intersection for comparison with the next faults
-				error_intersection.push(frInt);
+			kept += i;
+			for (; i < faults.size(); i++)
+				added.emplace_back(chip, faults[i]);
+		}
+	else
+		kept = 0, added.resize(1);
 
-				// we’ll come back here with the next fault range instead of this one
-				traversal.push(std::make_pair(chip, std::next(faultrange)));
+	if (added.size() > kept)
+		enumerate_intersections(cache, symbol_wild_mask);
+	else
+	{
+		if (!removed.empty())
+		{
+			std::vector<fault_set_t> sets;
+			std::vector<chip_fault_t> set_faults;
+			sets.reserve(cache.sets.size());
+			set_faults.reserve(cache.set_faults.size());
 
-				// advance to next chip since only fautl ranges on different faults can intersect
-				break;
+			for (fault_set_t set: cache.sets)
+			{
+				auto begin = cache.set_faults.cbegin() + set.first, end = begin + set.size;
+				if (std::any_of(begin, end, [&removed] (const chip_fault_t &f) { return removed.count(f.second) != 0; }))
+					continue;
+
+				set.first = set_faults.size();
+				set_faults.insert(set_faults.end(), begin, end);
+				sets.push_back(set);
 			}
 
-			// advance chip and set new FaultRange *faultrange here and not at the loop beginning,
-			// to allow the pop() mechanism to work
-			if (++chip != m_children.cend())
-				faultrange = dynamic_cast<DRAMDomain*>(*chip)->getRanges().cbegin();
+			cache.sets.swap(sets);
+			cache.set_faults.swap(set_faults);
 		}
 
-		FaultIntersection &intersection = error_intersection.top();
+		for (auto &fault: added)
+			add_intersections(cache, fault.first, fault.second, symbol_wild_mask);
+	}
+
+	cache.known_faults.resize(chips.size());
+	for (uint32_t chip = 0; chip < chips.size(); chip++)
+		cache.known_faults[chip].assign(chips[chip]->begin(), chips[chip]->end());
 
-		// mark intersecting errors based on how many intersection symbols are affected
-		// NB: for double chipkill we might mark a triple error and a double error containing this triple error
-		if (predicate(intersection))
-			m_failures.push_back(intersection);
+	return cache;
+}
 
-		error_intersection.pop();
+/** Enumerate all the sets of faults from distinct chips that intersect, with a DFS over the chips' faults.
+ *
+ * Frame d of the stack holds a set of d faults, extended in turn with each intersecting fault of each next chip. A set is
+ * complete, and stored, once all of its extensions are. This gives sets in the order of their fault index in each chip
+ * in turn, with no fault last.
+ */
+void GroupDomain_dimm::enumerate_intersections(intersection_cache_t &cache, uint64_t symbol_wild_mask)
+{
+	const std::vector<const FaultStore *> &chips = m_chip_faults;
+
+	cache.sets.clear();
+	cache.set_faults.clear();
+
+	size_t n_faults = 0;
+	for (const FaultStore *faults: chips)
+		n_faults += faults->size();
+
+	// With many faults, look up the candidates of each chip in a rank/bank/row index instead of scanning all its faults
+	const bool use_index = n_faults >= INDEX_THRESHOLD;
+	if (use_index)
+	{
+		DRAMDomain *dram = dynamic_cast<DRAMDomain*>(m_children.front());
+		m_index.build(chips, dram->getMask<Ranks>() | dram->getMask<Banks>() | dram->getMask<Rows>());
 	}
 
-	return m_failures;
+	m_dfs.resize(chips.size() + 1);
+	m_dfs[0] = dfs_frame_t{0ULL, ~0ULL, false, {0, nullptr}, 0, 0};
+	size_t depth = 0;
+
+	while (true)
+	{
+		dfs_frame_t &top = m_dfs[depth];
+
+		// find the next fault range that intersects the set, at symbol granularity, skipping chips without faults
+		for (; top.chip != chips.size(); ++top.chip, top.next = 0)
+		{
+			const FaultStore &faults = *chips[top.chip];
+			if (top.next == faults.size())
+				continue;
+
+			const uint64_t wildmask = top.mask | symbol_wild_mask;
+			top.next = use_index ? m_index.next_intersecting(top.chip, top.next, top.addr, wildmask)
+								 : faults.next_intersecting(top.next, top.addr, wildmask);
+
+			if (top.next != faults.size())
+				break;
+		}
+
+		if (top.chip != chips.size())
+		{
+			// extend the set with this fault, and come back to the next fault range of this chip afterwards
+			const FaultStore &faults = *chips[top.chip];
+			const size_t i = top.next++;
+			const uint64_t fault_mask = faults.mask(i) | symbol_wild_mask;
+
+			assert( (faults.addr(i) & faults.mask(i)) == 0 );
+
+			m_dfs[++depth] = dfs_frame_t{(faults.addr(i) & ~fault_mask) | (top.addr & ~top.mask), fault_mask & top.mask,
+										 top.transient || faults.transient(i), {top.chip, faults[i]}, top.chip + 1, 0};
+			continue;
+		}
+
+		cache.sets.push_back(fault_set_t{top.addr, top.mask, static_cast<uint32_t>(cache.set_faults.size()),
+										 static_cast<uint32_t>(depth), top.transient});
+		for (size_t d = 1; d <= depth; d++)
+			cache.set_faults.push_back(m_dfs[d].fault);
+
+		if (depth-- == 0)
+			break;
+	}
 }
 
-/* Removes duplicate failures
-void GroupDomain_dimm::failures_stats()
+/** Add the sets of faults formed by a new fault with the known sets it intersects, where the DFS would have found them.
+ *
+ * The DFS order compares sets by the index of their fault in each chip in turn, with no fault last. As the new fault has
+ * the highest index in its chip, the new sets go right before the run of sets that have the same faults in the previous
+ * chips and no fault in this chip, in the order of that run.
+ */
+void GroupDomain_dimm::add_intersections(intersection_cache_t &cache, uint32_t chip, FaultRange *fault,
+										 uint64_t symbol_wild_mask)
 {
-	if (failures.empty())
-		return;
+	const uint64_t fault_mask = fault->fWildMask | symbol_wild_mask;
 
-	failures.sort([] (FaultRange &a, FaultRange &b)
-		{
-			return std::make_tuple(a.outcome, a.fAddr, a.fAddr | a.fWildMask) < std::make_tuple(b.outcome, b.fAddr, b.fAddr | b.fWildMask);
-		});
+	// number of faults of a set in the chips before this one
+	auto prefix_size = [&cache, chip] (const fault_set_t &set) {
+		auto begin = cache.set_faults.cbegin() + set.first;
+		return static_cast<uint32_t>(std::find_if(begin, begin + set.size, [chip] (auto &f) { return f.first >= chip; }) - begin);
+	};
+
+	// new sets, with the index of the set before which they go
+	m_new_sets.clear();
 
-	for (auto it = failures.begin(), nx = std::next(it); nx != failures.end(); )
+	const size_t no_run = cache.sets.size();
+	size_t run = no_run;
+	uint32_t run_prefix = 0;
+	for (size_t i = 0; i < cache.sets.size(); i++)
 	{
-		uint64_t it_start = it->fAddr, it_end = (it_start | it->fWildMask) + 1; // it = {}
-		uint64_t nx_start = nx->fAddr, nx_end = (nx_start | nx->fWildMask) + 1; // nx = ()
-
-		// from sorting
-		assert (it_start <= nx_start);
-
-		if (it->outcome != nx->outcome || it_end <= nx_start)
-			// disjoint case it_start < it_end ≤ nx_start < nx_end { } ( )  , move on.
-			++nx, ++it;
-		else if (it_end >= nx_end)
-			// fully overlapping it_start ≤ nx_start ≤ nx_end ≤ it_end { ( ) }
-			nx = failures.erase(nx);
-		else if (it_start == nx_start)
+		const fault_set_t set = cache.sets[i];
+		const uint32_t prefix = prefix_size(set);
+		if (prefix != set.size && cache.set_faults[set.first + prefix].first == chip)
 		{
-			// fully overlapping it_start = nx_start ≤ it_end < nx_end  [({]  } )
-			it = failures.erase(it);
-			nx = std::next(it);
+			run = no_run;
+			continue;
 		}
-		else
+
+		if (run == no_run || run_prefix != prefix
+				|| !std::equal(cache.set_faults.cbegin() + set.first, cache.set_faults.cbegin() + set.first + prefix,
+							   cache.set_faults.cbegin() + cache.sets[run].first))
+			run = i, run_prefix = prefix;
+
+		if (((set.addr ^ fault->fAddr) & ~(set.mask | fault_mask)) != 0)
+			continue;
+
+		fault_set_t added{(set.addr & ~set.mask) | (fault->fAddr & ~fault_mask), set.mask & fault_mask,
+						  static_cast<uint32_t>(cache.set_faults.size()), set.size + 1, set.transient || fault->transient};
+
+		for (uint32_t f = 0; f != set.size + 1; f++)
 		{
-			// annoying overlap: it_start < nx_start < it_end < nx_end { ( } )
-			// Typically 2 columns in the same bank. If not, print a warning.
-			if (! (it->m_pDRAM->maskClass(it->fWildMask) == DRAM_1COL && nx->m_pDRAM->maskClass(nx->fWildMask) == DRAM_1COL
-						&& it->m_pDRAM->get<Ranks>(it->fWildMask) == nx->m_pDRAM->get<Ranks>(nx->fWildMask)
-						&& it->m_pDRAM->get<Banks>(it->fWildMask) == nx->m_pDRAM->get<Banks>(nx->fWildMask)
-				  ))
-				std::cout << "\nWARNING: unexpected partial overlap between ranges " << std::showbase << std::hex
-					<< it_start << " | " << it->fWildMask << " -> " << it_end - 1 << " and "
-					<< nx_start << " | " << nx->fWildMask << " -> " << nx_end - 1 << std::dec
-					<< "\n  " << *it << "\n  " << *nx << std::endl;
-
-			// Unsure masks can be combined, continue
-			++nx, ++it;
+			const chip_fault_t next = f == prefix ? chip_fault_t(chip, fault) : cache.set_faults[set.first + f - (f > prefix)];
+			cache.set_faults.push_back(next);
 		}
+
+		m_new_sets.emplace_back(run, added);
+	}
+
+	if (m_new_sets.empty())
+		return;
+
+	m_merged.clear();
+	auto next = m_new_sets.cbegin();
+	for (size_t i = 0; i < cache.sets.size(); i++)
+	{
+		for (; next != m_new_sets.cend() && next->first == i; ++next)
+			m_merged.push_back(next->second);
+		m_merged.push_back(cache.sets[i]);
 	}
+
+	cache.sets.swap(m_merged);
 }
-*/
@@ -23,12 +23,15 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GROUPDOMAIN_DIMM_HH_
 
 #include <iostream>
-#include <functional>
 #include <memory>
+#include <vector>
+#include <list>
+#include <utility>
 #include <math.h>
 
 #include "dram_common.hh"
 #include "GroupDomain.hh"
+#include "FaultIndex.hh"
 
 class GroupDomain_dimm : public GroupDomain
 {
@@ -39,37 +42,191 @@ class GroupDomain_dimm : public GroupDomain
 	/** The burst length per access, this determines the number of pins coming out of a Chip */
 	const uint64_t m_burst_size;
 
+	/** Repair context: the failures left by the repair schemes so far, and the failures selected by the current one */
 	std::list<FaultIntersection> m_failures;
+	std::vector<FaultIntersection *> m_selected;
 	bool m_failures_computed;
 
+	/** Number of faults in the module from which intersecting_ranges() uses m_index rather than plain scans */
+	static constexpr size_t INDEX_THRESHOLD = 32;
+	FaultIndex m_index;
+
+	typedef std::pair<uint32_t, FaultRange *> chip_fault_t;
+
+	/** Faults from distinct chips, set_faults[first, first + size) sorted by chip, and their intersection at symbol granularity */
+	struct fault_set_t
+	{
+		uint64_t addr, mask;
+		uint32_t first, size;
+		bool transient;
+	};
+
+	/** A set of faults being extended by the DFS, and the chip and fault index from which to look for its next fault */
+	struct dfs_frame_t
+	{
+		uint64_t addr, mask;
+		bool transient;
+		chip_fault_t fault;
+		uint32_t chip;
+		size_t next;
+	};
+
+	/** All the sets of faults that intersect at a symbol size, kept across repairs as faults get inserted and scrubbed */
+	struct intersection_cache_t
+	{
+		/** Symbol size of the sets, or -1 if they need to be enumerated */
+		int symbol_size;
+		/** The sets, in DFS order */
+		std::vector<fault_set_t> sets;
+		/** The faults of all the sets */
+		std::vector<chip_fault_t> set_faults;
+		/** The faults of each chip accounted for in the sets, in the order of the chip's fault store */
+		std::vector<std::vector<FaultRange *>> known_faults;
+
+		inline
+		void clear()
+		{
+			symbol_size = -1;
+			sets.clear();
+			set_faults.clear();
+			known_faults.clear();
+		}
+	};
+
+	/** Intersections at the symbol size of the first repair scheme, which the next schemes act on */
+	intersection_cache_t m_intersections;
+	/** The faults of each chip, as seen by the group */
+	std::vector<const FaultStore *> m_chip_faults;
+	/** DFS stack, one frame per chip in the set being extended plus one for the empty set */
+	std::vector<dfs_frame_t> m_dfs;
+	/** Scratch space of add_intersections() */
+	std::vector<std::pair<size_t, fault_set_t>> m_new_sets;
+	std::vector<fault_set_t> m_merged;
+
+	bool m_check_skipped_repairs;
+
 	GroupDomain_dimm(const std::string& name, uint64_t chips, uint64_t banks, uint64_t burst_length)
 		: GroupDomain(name)
 		, m_chips(chips), m_banks(banks), m_burst_size(burst_length)
-		, m_failures(), m_failures_computed(false)
+		, m_failures(), m_selected(), m_failures_computed(false), m_index()
+		, m_intersections{-1, {}, {}, {}}, m_chip_faults(), m_dfs(), m_new_sets(), m_merged()
+		, m_check_skipped_repairs(false)
 	{
 	}
 
+	bool cannot_fail(unsigned symbol_size, unsigned min_chips);
+	intersection_cache_t &update_intersections(unsigned symbol_size);
+	void enumerate_intersections(intersection_cache_t &cache, uint64_t symbol_wild_mask);
+	void add_intersections(intersection_cache_t &cache, uint32_t chip, FaultRange *fault, uint64_t symbol_wild_mask);
+	FaultIntersection make_intersection(const intersection_cache_t &cache, const fault_set_t &set, unsigned symbol_size) const;
+
 public:
+	/** Read-only view of a set of intersecting faults, for predicates to select failures before they are built */
+	class FaultSet
+	{
+		const chip_fault_t *m_faults;
+		size_t m_size;
+
+	public:
+		FaultSet(const chip_fault_t *faults, size_t size) : m_faults(faults), m_size(size) {}
+
+		inline
+		size_t chip_count() const
+		{
+			return m_size;
+		}
+
+		/** Same as FaultIntersection::bit_count_sum() */
+		inline
+		size_t bit_count_sum(size_t word_mask) const
+		{
+			size_t wrong_bits = 0;
+			for (size_t i = 0; i < m_size; i++)
+				wrong_bits += __builtin_popcount(m_faults[i].second->fWildMask & word_mask) + 1;
+
+			return wrong_bits;
+		}
+	};
+
+	/** Default predicate of intersecting_ranges(), selecting any set of faults */
+	struct any_fault
+	{
+		template<typename Set>
+		bool operator()(Set &set) const { return set.chip_count() > 0; }
+	};
+
 	static GroupDomain_dimm* genModule(Settings &settings, int module_id);
-	/** Return faults that intersect across children */
-	std::list<FaultIntersection>& intersecting_ranges(unsigned symbol_size,
-													  std::function<bool(FaultIntersection&)> predicate = [](auto &f){ return f.chip_count() > 0; });
 
-	inline
-	virtual failures_t repair()
+	/** This functions returns the list of fault intersections that intersect at a granularity given by symbol_size, subject
+	 * to being validated by the predicate, called on a FaultSet or on a FaultIntersection.
+	 *
+	 * For example, to access all faults that would cause a DUE in ChipKill, and the predicate should test whether the FaultIntersection
+	 * contains at least 2 symbols (as they are always from different chips).
+	 *
+	 * To access all faults that would cause DUE in 3EC4ED, the predicate should test whether the number erroneous bits in the
+	 * FaultIntersection is at lest 3.
+	 *
+	 * min_chips is the fewest chips for which predicate may hold, or 0 if unknown.
+	 *
+	 * The first scheme of a repair gets the failures from the intersections cached for its symbol size. The next schemes
+	 * act on the failures that the previous schemes left, of which the predicate selects some. Failures are returned by
+	 * pointer, so that the outcomes marked by a scheme are seen by the next ones. A scheme that tolerates a failure marks
+	 * it corrected, which leaves it out of the failures of the next schemes.
+	 */
+	template<typename Predicate = any_fault>
+	std::vector<FaultIntersection *>& intersecting_ranges(unsigned symbol_size, Predicate predicate = Predicate(), unsigned min_chips = 0)
 	{
-		m_failures.clear();
-		m_failures_computed = false;
+		m_selected.clear();
+
+		if (m_failures_computed)
+		{
+			for (FaultIntersection &failure: m_failures)
+				if (!failure.corrected() && predicate(failure))
+					m_selected.push_back(&failure);
+
+			return m_selected;
+		}
+		else
+			m_failures_computed = true;
+
+		if (cannot_fail(symbol_size, min_chips))
+			return m_selected;
+
+		const intersection_cache_t &cache = update_intersections(symbol_size);
+
+		// mark intersecting errors based on how many intersection symbols are affected
+		// NB: for double chipkill we might mark a triple error and a double error containing this triple error
+		for (const fault_set_t &set: cache.sets)
+		{
+			FaultSet view(cache.set_faults.data() + set.first, set.size);
+			if (predicate(view))
+			{
+				m_failures.push_back(make_intersection(cache, set, symbol_size));
+				m_selected.push_back(&m_failures.back());
+			}
+		}
+
+		return m_selected;
+	}
 
-		return GroupDomain::repair();
+	virtual failures_t repair();
+
+	/** Whether to run the repairs that are skipped anyway, to check they would not fail */
+	inline
+	void check_skipped_repairs(bool check)
+	{
+		m_check_skipped_repairs = check;
 	}
 
 	inline
 	virtual void reset()
 	{
 		m_failures.clear();
+		m_selected.clear();
 		m_failures_computed = false;
 
+		m_intersections.clear();
+
 		GroupDomain::reset();
 	}
 
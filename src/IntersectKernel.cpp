@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INTERSECT_X86
+#endif
+
+#include "IntersectKernel.hh"
+
+
+static uint64_t intersect_scalar(const uint64_t *addrs, const uint64_t *masks, size_t n, uint64_t address, uint64_t wildmask)
+{
+	uint64_t hits = 0;
+	for (size_t i = 0; i < n; i++)
+		hits |= static_cast<uint64_t>(((addrs[i] ^ address) & ~(masks[i] | wildmask)) == 0) << i;
+
+	return hits;
+}
+
+
+#ifdef INTERSECT_X86
+__attribute__((target("avx2")))
+static uint64_t intersect_avx2(const uint64_t *addrs, const uint64_t *masks, size_t n, uint64_t address, uint64_t wildmask)
+{
+	const __m256i query_addr = _mm256_set1_epi64x(address), query_mask = _mm256_set1_epi64x(wildmask);
+	const __m256i zero = _mm256_setzero_si256();
+
+	uint64_t hits = 0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i diff = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(addrs + i)), query_addr);
+		__m256i wild = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(masks + i)), query_mask);
+		__m256i equal = _mm256_cmpeq_epi64(_mm256_andnot_si256(wild, diff), zero);
+
+		hits |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(equal))) << i;
+	}
+
+	if (i < n)
+		hits |= intersect_scalar(addrs + i, masks + i, n - i, address, wildmask) << i;
+
+	return hits;
+}
+
+
+__attribute__((target("avx512f")))
+static uint64_t intersect_avx512(const uint64_t *addrs, const uint64_t *masks, size_t n, uint64_t address, uint64_t wildmask)
+{
+	const __m512i query_addr = _mm512_set1_epi64(address), query_mask = _mm512_set1_epi64(wildmask);
+	const __m512i ones = _mm512_set1_epi64(-1);
+
+	uint64_t hits = 0;
+	for (size_t i = 0; i < n; i += 8)
+	{
+		// masked loads for the last (partial) vector, the lanes outside of the range are ignored
+		__mmask8 lanes = n - i >= 8 ? 0xFF : (1U << (n - i)) - 1;
+		__m512i diff = _mm512_xor_si512(_mm512_maskz_loadu_epi64(lanes, addrs + i), query_addr);
+		// NB: _mm512_andnot_si512 trips -Wmaybe-uninitialized in GCC's headers, so negate the wildcards with a xor
+		__m512i keep = _mm512_xor_si512(_mm512_or_si512(_mm512_maskz_loadu_epi64(lanes, masks + i), query_mask), ones);
+
+		hits |= static_cast<uint64_t>(_mm512_mask_testn_epi64_mask(lanes, diff, keep)) << i;
+	}
+
+	return hits;
+}
+#endif
+
+
+const std::vector<std::pair<const char *, intersect_kernel_t>> &intersect_kernels()
+{
+	static const std::vector<std::pair<const char *, intersect_kernel_t>> kernels = [] () {
+		std::vector<std::pair<const char *, intersect_kernel_t>> supported = {{"scalar", intersect_scalar}};
+#ifdef INTERSECT_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			supported.emplace_back("avx2", intersect_avx2);
+		if (__builtin_cpu_supports("avx512f"))
+			supported.emplace_back("avx512", intersect_avx512);
+#endif
+		return supported;
+	}();
+
+	return kernels;
+}
+
+
+/** The widest supported kernel, unless the FAULTSIM_KERNEL environment variable names another */
+static intersect_kernel_t select_kernel()
+{
+	const auto &kernels = intersect_kernels();
+	const char *name = std::getenv("FAULTSIM_KERNEL");
+
+	if (name)
+		for (auto &kernel: kernels)
+			if (std::strcmp(kernel.first, name) == 0)
+				return kernel.second;
+
+	return kernels.back().second;
+}
+
+
+uint64_t intersect_batch(const uint64_t *addrs, const uint64_t *masks, size_t n, uint64_t address, uint64_t wildmask)
+{
+	static const intersect_kernel_t kernel = select_kernel();
+	return kernel(addrs, masks, n, address, wildmask);
+}
@@ -0,0 +1,42 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef INTERSECTKERNEL_HH_
+#define INTERSECTKERNEL_HH_
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/** Compute which of n <= 64 packed ranges (addrs[i], masks[i]) intersect the query range (address, wildmask)
+ *
+ * Returns a bitmask with bit i set if range i intersects, i.e. if both ranges have the same address bits outside of
+ * their combined wildcard masks. The implementation (AVX-512, AVX2 or scalar) is chosen at runtime for this CPU.
+ */
+uint64_t intersect_batch(const uint64_t *addrs, const uint64_t *masks, size_t n, uint64_t address, uint64_t wildmask);
+
+typedef uint64_t (*intersect_kernel_t)(const uint64_t *, const uint64_t *, size_t, uint64_t, uint64_t);
+
+/** All kernels that this CPU supports, by name, the scalar one first */
+const std::vector<std::pair<const char *, intersect_kernel_t>> &intersect_kernels();
+
+#endif /* INTERSECTKERNEL_HH_ */
@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2015, Advanced Micro Devices, Inc. All rights reserved.
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef RANDOMSTREAM_HH_
+#define RANDOMSTREAM_HH_
+
+#include <cstdint>
+#include <array>
+
+/** A counter-based random number generator: Philox4x32-10 (Salmon et al., “Parallel random numbers: as easy as 1, 2, 3”)
+ *
+ * Every number is a pure function of (global seed, simulation index, chip, purpose, draw index), so there is no state
+ * to share between threads and simulation k draws the same numbers whichever thread or shard runs it.
+ * This class satisfies UniformRandomBitGenerator, and can thus be used with the std distributions.
+ */
+class RandomStream
+{
+public:
+	typedef uint64_t result_type;
+
+	/** Distinguishes the streams that a single chip or module uses */
+	enum purpose_t : uint32_t
+	{
+		FAULT_TIMES = 0, FAULT_LOCATIONS, TSV_LOCATIONS, SW_TOLERANCE, SIM_EVENTS, BRANCH_SEEDS, TIER2_LOCATIONS, PROTECTED_ROWS, N_PURPOSES
+	};
+
+	/** Chip identifier used for streams that belong to a whole module rather than a chip */
+	static const uint32_t GROUP = 0xFFFFFF;
+
+	typedef std::array<uint32_t, 4> counter_t;
+	typedef std::array<uint32_t, 2> key_t;
+
+	inline
+	RandomStream(uint32_t chip = GROUP, purpose_t purpose = FAULT_TIMES)
+		: m_stream((chip << 8) | purpose), m_key({0, 0}), m_sim(0), m_draw(0), m_pos(2), m_buffer({0, 0})
+	{
+	}
+
+	/** Select the stream for the given simulation and rewind it */
+	inline
+	void seed(uint64_t global_seed, uint64_t sim_index)
+	{
+		m_key = {static_cast<uint32_t>(global_seed), static_cast<uint32_t>(global_seed >> 32)};
+		m_sim = sim_index;
+		m_draw = 0;
+		m_pos = 2;
+	}
+
+	inline
+	result_type operator()()
+	{
+		if (m_pos == 2)
+		{
+			counter_t block = philox({m_draw++, m_stream, static_cast<uint32_t>(m_sim), static_cast<uint32_t>(m_sim >> 32)}, m_key);
+			m_buffer[0] = (static_cast<uint64_t>(block[1]) << 32) | block[0];
+			m_buffer[1] = (static_cast<uint64_t>(block[3]) << 32) | block[2];
+			m_pos = 0;
+		}
+		return m_buffer[m_pos++];
+	}
+
+	/** The number at a given position of the stream, without drawing from it, e.g. for a fixed pseudo-random mapping */
+	inline
+	result_type at(uint32_t index) const
+	{
+		counter_t block = philox({index, m_stream, static_cast<uint32_t>(m_sim), static_cast<uint32_t>(m_sim >> 32)}, m_key);
+		return (static_cast<uint64_t>(block[1]) << 32) | block[0];
+	}
+
+	/** A number that is a pure function of the stream and of a 128-bit value (x, y), e.g. a location, without drawing */
+	inline
+	result_type at(uint64_t x, uint64_t y) const
+	{
+		counter_t block = philox({static_cast<uint32_t>(x), static_cast<uint32_t>(x >> 32),
+								  static_cast<uint32_t>(y), static_cast<uint32_t>(y >> 32)}, m_key);
+		block = philox({block[0] ^ m_stream, block[1], block[2] ^ static_cast<uint32_t>(m_sim),
+						block[3] ^ static_cast<uint32_t>(m_sim >> 32)}, m_key);
+		return (static_cast<uint64_t>(block[1]) << 32) | block[0];
+	}
+
+	/** Map a number of the stream to a uniform double in [0, 1), from its 53 highest bits */
+	static inline
+	double uniform(result_type number)
+	{
+		return (number >> 11) * 0x1.0p-53;
+	}
+
+	/** Derive an independent global seed for a branch of a simulation, e.g. a clone when splitting */
+	static inline
+	uint64_t derive(uint64_t global_seed, uint64_t branch)
+	{
+		counter_t block = philox({static_cast<uint32_t>(branch), static_cast<uint32_t>(branch >> 32), BRANCH_SEEDS, GROUP},
+								 {static_cast<uint32_t>(global_seed), static_cast<uint32_t>(global_seed >> 32)});
+		return (static_cast<uint64_t>(block[1]) << 32) | block[0];
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~0ULL; }
+
+	/** The Philox4x32 bijection with 10 rounds */
+	static inline
+	counter_t philox(counter_t ctr, key_t key)
+	{
+		const uint64_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+		const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+		for (int round = 0; round < 10; round++)
+		{
+			if (round)
+				key[0] += W0, key[1] += W1;
+
+			uint64_t prod0 = M0 * ctr[0], prod1 = M1 * ctr[2];
+			ctr = {static_cast<uint32_t>(prod1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(prod1),
+				   static_cast<uint32_t>(prod0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(prod0)};
+		}
+
+		return ctr;
+	}
+
+private:
+	uint32_t m_stream;
+	key_t m_key;
+	uint64_t m_sim;
+	uint32_t m_draw, m_pos;
+	std::array<uint64_t, 2> m_buffer;
+};
+
+#endif /* RANDOMSTREAM_HH_ */
@@ -51,6 +51,21 @@ public:
 	virtual failures_t repair(FaultDomain *fd) = 0;
 	virtual void reset() = 0;
 
+	/** Minimum number of faults needed for this scheme to report a failure */
+	virtual unsigned failure_threshold() const
+	{
+		return 1;
+	}
+
+	/** Select the random streams for a given simulation */
+	virtual void seed(uint64_t global_seed [[gnu::unused]], uint64_t sim_index [[gnu::unused]]) {}
+
+	/** Select the random streams for a clone of a simulation, by default as for a new simulation */
+	virtual void seed_clone(uint64_t clone_seed, uint64_t sim_index)
+	{
+		seed(clone_seed, sim_index);
+	}
+
 	virtual void printStats() {}
 };
 
@@ -22,6 +22,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unordered_map>
 #include <iostream>
 #include <sstream>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cmath>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
@@ -112,6 +116,8 @@ int Settings::parse_settings(const std::string &ininame, std::vector<std::string
 	boost::property_tree::ini_parser::read_ini(ininame.c_str(), pt);
 
 	container_translator<std::vector<double>> vec_tr;
+	container_translator<std::vector<unsigned>> uvec_tr;
+	enum_translator<decltype(estimator)> estimator_tr({{"plain", PLAIN}, {"conditional", CONDITIONAL}, {"importance", IMPORTANCE}, {"splitting", SPLITTING}});
 	enum_translator<decltype(organization)> org_tr({{"dimm", DIMM}, {"stack", STACK_3D}});
 	enum_translator<decltype(cube_model)> cube_tr({{"vertical", VERTICAL}, {"horizontal", HORIZONTAL}});
 	enum_translator<decltype(faultmode)> fm_tr({{"jaguar", JAGUAR}, {"uniformbit", UNIFORM_BIT}, {"manual", MANUAL}});
@@ -144,6 +150,28 @@ int Settings::parse_settings(const std::string &ininame, std::vector<std::string
 		continue_running = pt.get<bool>("sim.continue_running");
 		verbose = pt.get<int>("sim.verbose");
 		debug = pt.get<int>("sim.debug");
+		skip_fault_free = pt.get<bool>("sim.skip_fault_free", false);
+		hugepages = pt.get<bool>("sim.hugepages", false);
+		check_skipped_repairs = pt.get<bool>("sim.check_skipped_repairs", false);
+		estimator = pt.get<decltype(estimator)>("sim.estimator", PLAIN, estimator_tr);
+		split_levels = pt.get<std::vector<unsigned>>("sim.split_levels", std::vector<unsigned>{1}, uvec_tr);
+		split_factor = pt.get<unsigned>("sim.split_factor", 10);
+
+		if (split_factor == 0 || split_levels.empty() || !std::is_sorted(split_levels.begin(), split_levels.end(), std::less_equal<unsigned>()))
+		{
+			std::cerr << "ERROR: Splitting requires a positive factor and strictly increasing levels\n";
+			std::abort();
+		}
+
+		if (pt.get_optional<uint64_t>("sim.seed"))
+			seed = pt.get<uint64_t>("sim.seed");
+		else
+		{
+			// No seed given: pick one, and print it so that the run can be reproduced
+			std::random_device rd;
+			seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+			std::cout << "  + random seed sim.seed=" << seed << std::endl;
+		}
 
 		organization = pt.get<decltype(organization)>("org.organization", org_tr);
 		chips_per_rank = pt.get<int>("org.chips_per_rank");
@@ -194,6 +222,21 @@ int Settings::parse_settings(const std::string &ininame, std::vector<std::string
 			}
 		}
 
+		// one factor for all fault classes, or one per class in order, starting with 1BIT
+		is_bias = pt.get<std::vector<double>>("fault.is_bias", std::vector<double>{1.}, vec_tr);
+		if (is_bias.size() == 1)
+			is_bias.resize(DRAM_MAX, is_bias.front());
+		else if (is_bias.size() != DRAM_MAX)
+		{
+			std::cerr << "ERROR: Wrong number of importance sampling bias factors\n";
+			std::abort();
+		}
+		if (std::any_of(is_bias.begin(), is_bias.end(), [] (double b) { return !std::isfinite(b) || b <= 0.; }))
+		{
+			std::cerr << "ERROR: Importance sampling bias factors must be positive and finite\n";
+			std::abort();
+		}
+
 		repairmode = pt.get<decltype(repairmode)>("ECC.repairmode", repair_tr);
 
 		// specify all the tolerance probabilities, in order, starting with 1WORD
@@ -44,6 +44,20 @@ struct Settings
 	int verbose;
 	/** Enable a lot of printing */
 	bool debug;
+	/** Which Monte Carlo estimator to use: plain, conditional on the number of faults that can cause an error,
+	 * importance sampling of faults with FIT rates inflated by is_bias, or multilevel splitting */
+	enum {PLAIN, CONDITIONAL, IMPORTANCE, SPLITTING} estimator;
+	/** Danger levels (chips with faults in a same bank) at which simulations are split, and number of clones per split */
+	std::vector<unsigned> split_levels;
+	unsigned split_factor;
+	/** Draw whether a simulation has any faults, before generating them, and skip fault-free simulations */
+	bool skip_fault_free;
+	/** Back the memory of the faults of each simulation with hugepages */
+	bool hugepages;
+	/** Debug mode: run the repairs that modules skip as unable to fail, and abort if they do fail */
+	bool check_skipped_repairs;
+	/** Seed of all the random streams, simulation k of a run with a given seed always draws the same numbers */
+	uint64_t seed;
 
 
 	/** The topology to simulate */
@@ -86,6 +100,9 @@ struct Settings
 	/** Permanent fault rates, default to the values from Jaguar supercomputer */
 	std::vector<double> fit_permanent{18.6, 0.3, 5.6, 8.2, 10.0, 1.4, 2.8};
 
+	/** Factors by which to inflate the FIT rate of each fault class when using importance sampling */
+	std::vector<double> is_bias;
+
 
 	// ECC configuration
 
@@ -25,20 +25,35 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
+#include <thread>
+#include <memory>
+#include <random>
+#include <cmath>
 
 #include "Simulation.hh"
 #include "FaultDomain.hh"
 #include "DRAMDomain.hh"
 
 
-Simulation::Simulation(uint64_t scrub_interval, bool debug_mode, bool cont_running, uint64_t output_bucket)
+Simulation::Simulation(uint64_t scrub_interval, bool debug_mode, bool cont_running, uint64_t output_bucket, uint64_t seed)
 	: m_scrub_interval(scrub_interval)
 	, m_debug_mode(debug_mode)
 	, m_cont_running(cont_running)
 	, m_output_bucket(output_bucket)
+	, m_seed(seed)
+	, m_threads(1)
+	, m_genModule()
+	, m_skip_fault_free(false)
+	, m_gen(RandomStream::GROUP, RandomStream::SIM_EVENTS)
+	, m_estimator(Settings::PLAIN)
+	, m_fault_threshold(1), m_fault_mean(0.), m_p_threshold(1.), m_p_below(0.)
+	, m_is_bias(DRAM_MAX, 1.), m_is_no_fault_ratio(1.)
+	, m_split_levels(), m_split_factor(1), m_sim_index(0)
+	, m_fault_sources(), m_fault_source_table(), m_fault_rate(0.), m_original_fault_rate(0.), m_exponential(false)
 	, stat_total_failures(0)
 	, stat_total_corrected(0)
 	, stat_total_sims(0)
+	, stat_weighted_failures(0.)
 {
 }
 
@@ -55,16 +70,43 @@ void Simulation::addDomain(GroupDomain *domain)
 	m_domains.push_back(domain);
 }
 
+void Simulation::setThreads(unsigned n_threads, std::function<GroupDomain *()> genModule)
+{
+	m_threads = std::max(n_threads, 1U);
+	m_genModule = genModule;
+}
+
+void Simulation::setSkipFaultFree(bool skip)
+{
+	m_skip_fault_free = skip;
+}
+
+void Simulation::setEstimator(decltype(Settings::estimator) estimator)
+{
+	m_estimator = estimator;
+}
+
+void Simulation::setImportanceBias(const std::vector<double> &bias)
+{
+	m_is_bias = bias;
+}
+
+void Simulation::setSplitting(const std::vector<unsigned> &levels, unsigned factor)
+{
+	m_split_levels = levels;
+	m_split_factor = factor;
+}
+
 void Simulation::reset()
 {
 	for (GroupDomain *fd: m_domains)
 		fd->reset();
 }
 
-void Simulation::finalize()
+void Simulation::finalize(double weight)
 {
 	for (GroupDomain *fd: m_domains)
-		fd->finalize();
+		fd->finalize(weight);
 }
 
 void Simulation::simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::ofstream &opfile)
@@ -77,6 +119,20 @@ void Simulation::simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::
 	fail_undetectable.clear();
 	fail_undetectable.resize(max_time / m_output_bucket + 1, 0);
 
+	fail_time_weights.clear();
+	fail_time_weights.resize(max_time / m_output_bucket + 1, 0.);
+	fail_uncorrectable_weights.clear();
+	fail_uncorrectable_weights.resize(max_time / m_output_bucket + 1, 0.);
+	fail_undetectable_weights.clear();
+	fail_undetectable_weights.resize(max_time / m_output_bucket + 1, 0.);
+
+	fail_time_squares.clear();
+	fail_time_squares.resize(max_time / m_output_bucket + 1, 0.);
+	fail_uncorrectable_squares.clear();
+	fail_uncorrectable_squares.resize(max_time / m_output_bucket + 1, 0.);
+	fail_undetectable_squares.clear();
+	fail_undetectable_squares.resize(max_time / m_output_bucket + 1, 0.);
+
 	if (verbose)
 	{
 		std::cout << "# ===================================================================\n";
@@ -84,38 +140,47 @@ void Simulation::simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::
 		std::cout << "# ===================================================================\n\n";
 	}
 
-	/**************************************************************
-	 * MONTE CARLO SIMULATION LOOP : THIS IS THE HEART OF FAULTSIM *
-	 **************************************************************/
-	for (uint64_t i = 0; i < n_sims; i++)
+	if (m_threads > 1 && m_genModule)
 	{
+		// Each worker owns a separate copy of the module and its own statistics, merged into this object at the end.
+		std::vector<std::unique_ptr<Simulation>> workers;
+		std::vector<std::thread> threads;
 
-		uint64_t failures = runOne(max_time, verbose, m_output_bucket);
-		stat_total_sims++;
-
-		faults_t fault_count = {0, 0};
-		for (GroupDomain *fd: m_domains)
-			fault_count += fd->getFaultCount();
-
-		if (failures != 0)
-		{
-			stat_total_failures++;
-			if (verbose) std::cout << "F";   // uncorrected
-		}
-		else if (fault_count.total() != 0)
+		for (unsigned t = 1; t < m_threads; t++)
 		{
-			stat_total_corrected++;
-			if (verbose) std::cout << "C";    // corrected
+			workers.emplace_back(new Simulation(m_scrub_interval, m_debug_mode, m_cont_running, m_output_bucket, m_seed));
+			workers.back()->addDomain(m_genModule());
+			workers.back()->setSkipFaultFree(m_skip_fault_free);
+			workers.back()->setEstimator(m_estimator);
+			workers.back()->setImportanceBias(m_is_bias);
+			workers.back()->setSplitting(m_split_levels, m_split_factor);
+			workers.back()->fail_time_bins = fail_time_bins;
+			workers.back()->fail_uncorrectable = fail_uncorrectable;
+			workers.back()->fail_undetectable = fail_undetectable;
+			workers.back()->fail_time_weights = fail_time_weights;
+			workers.back()->fail_uncorrectable_weights = fail_uncorrectable_weights;
+			workers.back()->fail_undetectable_weights = fail_undetectable_weights;
+			workers.back()->fail_time_squares = fail_time_squares;
+			workers.back()->fail_uncorrectable_squares = fail_uncorrectable_squares;
+			workers.back()->fail_undetectable_squares = fail_undetectable_squares;
 		}
-		else
+
+		// Split the simulations as evenly as possible in contiguous ranges, this thread takes the first share
+		auto first_sim = [n_sims, this] (unsigned t) { return t * (n_sims / m_threads) + std::min<uint64_t>(t, n_sims % m_threads); };
+
+		for (unsigned t = 1; t < m_threads; t++)
+			threads.emplace_back(&Simulation::run, workers[t - 1].get(), max_time, first_sim(t), first_sim(t + 1) - first_sim(t), verbose);
+
+		run(max_time, 0, first_sim(1), verbose);
+
+		for (unsigned t = 1; t < m_threads; t++)
 		{
-			if (verbose) std::cout << ".";   // no failures
+			threads[t - 1].join();
+			merge(*workers[t - 1]);
 		}
-
-		if (verbose) fflush(stdout);
-		reset();
 	}
-	/**************************************************************/
+	else
+		run(max_time, 0, n_sims, verbose);
 
 	if (verbose)
 	{
@@ -128,15 +193,45 @@ void Simulation::simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::
 			<< stat_total_failures << " failed and "
 			<< stat_total_corrected << " encountered correctable errors\n";
 
+	if (m_estimator == Settings::CONDITIONAL)
+	{
+		// Simulations with faults but too few to cause errors were not run, they all contribute raw faults.
+		for (GroupDomain *fd: m_domains)
+			fd->add_fault_weight(stat_total_sims * m_p_below);
+
+		std::cout << "Simulations conditioned on at least " << m_fault_threshold << " faults, of probability " << m_p_threshold
+				<< ": estimated probability of failure " << stat_weighted_failures / n_sims << '\n';
+	}
+	else if (m_estimator == Settings::SPLITTING)
+		std::cout << "Simulations split " << m_split_factor << " ways at " << m_split_levels.size() << " danger levels"
+				<< ": estimated probability of failure " << stat_weighted_failures / n_sims << '\n';
+	else if (m_estimator == Settings::IMPORTANCE)
+		std::cout << "Faults sampled at " << m_fault_rate / m_original_fault_rate << " times their rate"
+				<< ": estimated probability of failure " << stat_weighted_failures / n_sims << '\n';
+
 	opfile << "WEEKS,FAULT,FAULT-CUMU,P(FAULT),P(FAULT-CUMU)"
 			<< ",UNCORRECTABLE,UNCORRECTABLE-CUMU,P(UNCORRECTABLE),P(UNCORRECTABLE-CUMU)"
-			<< ",UNDETECTABLE,UNDETECTABLE-CUMU,P(UNDETECTABLE),P(UNDETECTABLE-CUMU)"
-	    << std::endl;
+			<< ",UNDETECTABLE,UNDETECTABLE-CUMU,P(UNDETECTABLE),P(UNDETECTABLE-CUMU)";
+	if (m_estimator != Settings::PLAIN)
+		opfile << ",STDERR(P(FAULT)),STDERR(P(UNCORRECTABLE)),STDERR(P(UNDETECTABLE))";
+	opfile << std::endl;
+
+	// Standard error of the mean of the simulations' weighted contributions to a bin
+	auto std_error = [n_sims] (double sum, double sum_squares) {
+		return n_sims > 1 ? std::sqrt(std::max(sum_squares / n_sims - (sum / n_sims) * (sum / n_sims), 0.) / (n_sims - 1)) : 0.;
+	};
 
 	int64_t fail_cumulative = 0;
 	int64_t uncorrectable_cumulative = 0;
 	int64_t undetectable_cumulative = 0;
 
+	double fail_weight_cumulative = 0.;
+	double uncorrectable_weight_cumulative = 0.;
+	double undetectable_weight_cumulative = 0.;
+
+	// Estimators other than plain Monte Carlo are meant for small probabilities
+	const int precision = m_estimator == Settings::PLAIN ? 6 : 12;
+
 	const double per_sim = 1. / n_sims;
 	const uint64_t week_secs = 7 * 24 * 3600;
 	for (uint64_t jj = 0; jj < fail_time_bins.size(); jj++)
@@ -145,62 +240,350 @@ void Simulation::simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::
 		uncorrectable_cumulative += fail_uncorrectable[jj];
 		undetectable_cumulative += fail_undetectable[jj];
 
-		double p_fail = fail_time_bins[jj] * per_sim;
-		double p_uncorrectable = fail_uncorrectable[jj] * per_sim;
-		double p_undetectable = fail_undetectable[jj] * per_sim;
+		fail_weight_cumulative += fail_time_weights[jj];
+		uncorrectable_weight_cumulative += fail_uncorrectable_weights[jj];
+		undetectable_weight_cumulative += fail_undetectable_weights[jj];
+
+		double p_fail = fail_time_weights[jj] * per_sim;
+		double p_uncorrectable = fail_uncorrectable_weights[jj] * per_sim;
+		double p_undetectable = fail_undetectable_weights[jj] * per_sim;
 
-		double p_fail_cumulative = fail_cumulative * per_sim;
-		double p_uncorrectable_cumulative = uncorrectable_cumulative * per_sim;
-		double p_undetectable_cumulative = undetectable_cumulative * per_sim;
+		double p_fail_cumulative = fail_weight_cumulative * per_sim;
+		double p_uncorrectable_cumulative = uncorrectable_weight_cumulative * per_sim;
+		double p_undetectable_cumulative = undetectable_weight_cumulative * per_sim;
 
 		opfile << (jj * m_output_bucket) / week_secs
 			<< ',' << fail_time_bins[jj]
 			<< ',' << fail_cumulative
-			<< ',' << std::fixed << std::setprecision(6) << p_fail
-			<< ',' << std::fixed << std::setprecision(6) << p_fail_cumulative
+			<< ',' << std::fixed << std::setprecision(precision) << p_fail
+			<< ',' << std::fixed << std::setprecision(precision) << p_fail_cumulative
 			<< ',' << fail_uncorrectable[jj]
 			<< ',' << uncorrectable_cumulative
-			<< ',' << std::fixed << std::setprecision(6) << p_uncorrectable
+			<< ',' << std::fixed << std::setprecision(precision) << p_uncorrectable
 			<< ',' << p_uncorrectable_cumulative
 			<< ',' << fail_undetectable[jj]
 			<< ',' << undetectable_cumulative
-			<< ',' << std::fixed << std::setprecision(6) << p_undetectable
-			<< ',' << p_undetectable_cumulative
-			<< '\n';
+			<< ',' << std::fixed << std::setprecision(precision) << p_undetectable
+			<< ',' << p_undetectable_cumulative;
+
+		if (m_estimator != Settings::PLAIN)
+			opfile << ',' << std_error(fail_time_weights[jj], fail_time_squares[jj])
+				<< ',' << std_error(fail_uncorrectable_weights[jj], fail_uncorrectable_squares[jj])
+				<< ',' << std_error(fail_undetectable_weights[jj], fail_undetectable_squares[jj]);
+
+		opfile << '\n';
 	}
 }
 
+void Simulation::run(uint64_t max_time, uint64_t first_sim, uint64_t n_sims, int verbose)
+{
+	// The time to the first fault of the module is exponential only if every fault arrival process is
+	prepare_fault_sources();
+	prepare_estimator(max_time);
+	const bool skip_fault_free = m_skip_fault_free && m_exponential;
+
+	sim_bin_weights.assign(fail_time_bins.size(), {0., 0., 0.});
+	sim_bins.clear();
+
+	/**************************************************************
+	 * MONTE CARLO SIMULATION LOOP : THIS IS THE HEART OF FAULTSIM *
+	 **************************************************************/
+	for (uint64_t i = first_sim; i < first_sim + n_sims; i++)
+	{
+		// Simulation i always uses the same random streams, regardless of which thread runs it
+		for (GroupDomain *fd: m_domains)
+			fd->seed(m_seed, i);
+		m_gen.seed(m_seed, i);
+		m_sim_index = i;
+
+		std::vector<fault_event_t> q1;
+		double weight = 1.;
+
+		if (m_estimator == Settings::CONDITIONAL && m_p_threshold > 0.)
+		{
+			// Only simulate the (rare) cases with enough faults to cause an error, weighted by their probability
+			generate_n_faults(q1, max_time, draw_fault_count());
+			weight = m_p_threshold;
+		}
+		else if (m_estimator == Settings::CONDITIONAL || skip_fault_free)
+		{
+			double first_fault = m_fault_rate > 0. ? std::exponential_distribution<double>(m_fault_rate)(m_gen) : INFINITY;
+
+			// No faults at all: count the simulation without going through the domains
+			if (first_fault > max_time)
+			{
+				stat_total_sims++;
+				for (GroupDomain *fd: m_domains)
+					fd->skip_fault_free();
+
+				if (verbose) std::cout << ".";   // no failures
+				continue;
+			}
+
+			weight = generate_faults(q1, max_time, first_fault);
+		}
+		else
+			weight = generate_faults(q1, max_time);
+
+		double failures = runOne(max_time, verbose, m_output_bucket, q1, weight);
+		close_sim_bins();
+		stat_total_sims++;
+
+		faults_t fault_count = {0, 0};
+		for (GroupDomain *fd: m_domains)
+			fault_count += fd->getFaultCount();
+
+		if (failures != 0.)
+		{
+			stat_total_failures++;
+			stat_weighted_failures += failures;
+			if (verbose) std::cout << "F";   // uncorrected
+		}
+		else if (fault_count.total() != 0)
+		{
+			stat_total_corrected++;
+			if (verbose) std::cout << "C";    // corrected
+		}
+		else
+		{
+			if (verbose) std::cout << ".";   // no failures
+		}
 
-uint64_t Simulation::runOne(const uint64_t max_s, int verbose, uint64_t bin_length)
+		if (verbose) fflush(stdout);
+		reset();
+	}
+	/**************************************************************/
+}
+
+void Simulation::merge(const Simulation &other)
 {
-	// Generate all the fault events that will happen
-	std::vector<std::pair<double, FaultRange *>> q1;
+	stat_total_sims += other.stat_total_sims;
+	stat_total_failures += other.stat_total_failures;
+	stat_total_corrected += other.stat_total_corrected;
+	stat_weighted_failures += other.stat_weighted_failures;
+
+	for (size_t bin = 0; bin < fail_time_bins.size(); bin++)
+	{
+		fail_time_bins[bin] += other.fail_time_bins[bin];
+		fail_uncorrectable[bin] += other.fail_uncorrectable[bin];
+		fail_undetectable[bin] += other.fail_undetectable[bin];
+
+		fail_time_weights[bin] += other.fail_time_weights[bin];
+		fail_uncorrectable_weights[bin] += other.fail_uncorrectable_weights[bin];
+		fail_undetectable_weights[bin] += other.fail_undetectable_weights[bin];
+
+		fail_time_squares[bin] += other.fail_time_squares[bin];
+		fail_uncorrectable_squares[bin] += other.fail_uncorrectable_squares[bin];
+		fail_undetectable_squares[bin] += other.fail_undetectable_squares[bin];
+	}
+
+	auto theirs = other.m_domains.cbegin();
+	for (auto mine = m_domains.begin(); mine != m_domains.end() && theirs != other.m_domains.cend(); ++mine, ++theirs)
+		(*mine)->merge(**theirs);
+}
+
+
+void Simulation::prepare_fault_sources()
+{
+	std::vector<double> rates;
+	m_fault_sources.clear();
+	m_fault_rate = 0.;
+	m_original_fault_rate = 0.;
+	m_exponential = true;
+
 	for (GroupDomain *fd: m_domains)
 		for (FaultDomain *fr: fd->getChildren())
 		{
 			DRAMDomain *chip = dynamic_cast<DRAMDomain *>(fr);
+			m_exponential = m_exponential && chip->exponential();
+
 			for (int errtype = 0; errtype < DRAM_MAX * 2; errtype++)
 			{
 				bool transient = errtype % 2;
 				fault_class_t fault = fault_class_t(errtype / 2);
 
-				double event_time = 0, max_time = max_s;
-				while ((event_time += chip->next_fault_event(fault, transient)) <= max_time)
-					q1.push_back(std::make_pair(event_time, chip->genRandomRange(fault, transient)));
+				double rate = chip->fault_rate(fault, transient);
+				if (rate == 0.)
+					continue;
+
+				// Importance sampling: sample faults from inflated rates, and keep the likelihood ratio to weight them
+				double bias = m_estimator == Settings::IMPORTANCE ? m_is_bias[fault] : 1.;
+
+				m_fault_sources.push_back({chip, fault, transient, 1. / bias});
+				rates.push_back(rate * bias);
+				m_fault_rate += rate * bias;
+				m_original_fault_rate += rate;
 			}
 		}
 
+	if (!rates.empty())
+		m_fault_source_table = AliasTable(rates);
+}
+
+
+void Simulation::prepare_estimator(uint64_t max_time)
+{
+	if (m_estimator != Settings::PLAIN && !m_exponential)
+	{
+		std::cerr << "ERROR: estimators other than plain Monte Carlo require exponential fault inter-arrival times\n";
+		std::abort();
+	}
+
+	// Likelihood ratio of the original over the sampled Poisson processes, on a simulation without faults
+	m_is_no_fault_ratio = std::exp((m_fault_rate - m_original_fault_rate) * max_time);
+
+	if (m_estimator != Settings::CONDITIONAL)
+		return;
+
+	// Errors in any domain are errors of the simulation
+	m_fault_threshold = ~0U;
+	for (GroupDomain *fd: m_domains)
+		m_fault_threshold = std::min(m_fault_threshold, fd->failure_threshold());
+
+	// The number of faults in a simulation is Poisson-distributed. Sum the tail rather than computing 1 - P(K < threshold)
+	// to avoid cancellation errors, as the tail probability can be very small.
+	const double mean = m_fault_mean = m_fault_rate * max_time;
+	m_p_threshold = 0.;
+	m_p_below = 0.;
+
+	if (mean == 0.)
+		return;
+
+	double term = std::exp(-mean + m_fault_threshold * std::log(mean) - std::lgamma(m_fault_threshold + 1.));
+	for (uint64_t k = m_fault_threshold; term > 0. && (k <= mean || term > 1e-18 * m_p_threshold); term *= mean / ++k)
+		m_p_threshold += term;
+
+	term = std::exp(-mean);
+	for (uint64_t k = 1; k < m_fault_threshold; k++)
+		m_p_below += (term *= mean / k);
+}
+
+
+uint64_t Simulation::draw_fault_count()
+{
+	// Inverse transform sampling of a Poisson distribution, truncated to values of at least m_fault_threshold
+	const double target = std::uniform_real_distribution<double>(0., m_p_threshold)(m_gen);
+
+	uint64_t k = m_fault_threshold;
+	double term = std::exp(-m_fault_mean + k * std::log(m_fault_mean) - std::lgamma(k + 1.)), cumulated = term;
+	while (cumulated < target && term > 0.)
+	{
+		term *= m_fault_mean / ++k;
+		cumulated += term;
+	}
+
+	return k;
+}
+
+
+double Simulation::generate_faults(std::vector<fault_event_t> &q1, const uint64_t max_s, double first_fault)
+{
+	double likelihood_ratio = m_is_no_fault_ratio;
+
+	if (m_exponential && m_fault_rate > 0.)
+	{
+		// The superposition of all the Poisson fault arrival processes is a Poisson process with the total rate, whose
+		// events each belong to a process chosen proportionally to its rate: this generates the events in arrival order.
+		// If the time of the first fault is given, all processes restart at that time since they are memoryless.
+		std::exponential_distribution<double> inter_arrival(m_fault_rate);
+
+		for (double event_time = first_fault > 0. ? first_fault : inter_arrival(m_gen); event_time <= max_s;
+				event_time += inter_arrival(m_gen))
+		{
+			const fault_source_t &source = m_fault_sources[m_fault_source_table(m_gen)];
+			q1.push_back(std::make_pair(event_time, source.chip->genRandomRange(source.fault, source.transient)));
+			likelihood_ratio *= source.likelihood_ratio;
+		}
+	}
+	else if (!m_exponential)
+	{
+		for (GroupDomain *fd: m_domains)
+			for (FaultDomain *fr: fd->getChildren())
+			{
+				DRAMDomain *chip = dynamic_cast<DRAMDomain *>(fr);
+				for (int errtype = 0; errtype < DRAM_MAX * 2; errtype++)
+				{
+					bool transient = errtype % 2;
+					fault_class_t fault = fault_class_t(errtype / 2);
+
+					double event_time = 0, max_time = max_s;
+					while ((event_time += chip->next_fault_event(fault, transient)) <= max_time)
+						q1.push_back(std::make_pair(event_time, chip->genRandomRange(fault, transient)));
+				}
+			}
+
+		// Sort the fault events in arrival order
+		std::sort(q1.begin(), q1.end(), [] (auto &a, auto &b) { return (a.first < b.first); });
+	}
+
+	return likelihood_ratio;
+}
+
 
+void Simulation::generate_n_faults(std::vector<fault_event_t> &q1, const uint64_t max_s, uint64_t n_faults)
+{
+	// Given their number, the arrival times of a Poisson process are uniformly distributed. Generate them in order by
+	// normalizing the cumulated sums of n + 1 exponentially distributed spacings.
+	std::exponential_distribution<double> spacing(1.);
+	std::vector<double> arrival(n_faults + 1);
+
+	double cumulated = 0.;
+	for (double &time: arrival)
+		time = (cumulated += spacing(m_gen));
+
+	for (uint64_t n = 0; n < n_faults; n++)
+	{
+		const fault_source_t &source = m_fault_sources[m_fault_source_table(m_gen)];
+		q1.push_back(std::make_pair(max_s * arrival[n] / cumulated, source.chip->genRandomRange(source.fault, source.transient)));
+	}
+}
+
+
+void Simulation::record_failure(uint64_t bin, const failures_t &failure_count, double weight)
+{
+	if (sim_bin_weights[bin][0] == 0.)
+		sim_bins.push_back(bin);
+
+	fail_time_bins[bin]++;
+	fail_time_weights[bin] += weight;
+	sim_bin_weights[bin][0] += weight;
+
+	if (failure_count.uncorrected > 0)
+	{
+		fail_uncorrectable[bin]++;
+		fail_uncorrectable_weights[bin] += weight;
+		sim_bin_weights[bin][1] += weight;
+	}
+	if (failure_count.undetected > 0)
+	{
+		fail_undetectable[bin]++;
+		fail_undetectable_weights[bin] += weight;
+		sim_bin_weights[bin][2] += weight;
+	}
+}
+
+
+void Simulation::close_sim_bins()
+{
+	for (uint64_t bin: sim_bins)
+	{
+		fail_time_squares[bin] += sim_bin_weights[bin][0] * sim_bin_weights[bin][0];
+		fail_uncorrectable_squares[bin] += sim_bin_weights[bin][1] * sim_bin_weights[bin][1];
+		fail_undetectable_squares[bin] += sim_bin_weights[bin][2] * sim_bin_weights[bin][2];
+		sim_bin_weights[bin] = {0., 0., 0.};
+	}
+	sim_bins.clear();
+}
+
+
+double Simulation::runOne(const uint64_t max_s, int verbose, uint64_t bin_length, std::vector<fault_event_t> &q1, double weight,
+						  unsigned split_level, uint64_t split_path)
+{
 	/* TODO:
 	 * Allow GroupDomain-level error injections, probably using a GroupDomain-level function
 	 * that does nothing from GroupDomain_dimm and inserts TSV faults for GroupDomain_cube.
 	 * */
 
-	// Sort the fault events in arrival order
-	std::sort(q1.begin(), q1.end(), [] (auto &a, auto &b) { return (a.first < b.first); });
-
-
-	uint64_t errors = 0;
 
 	// Step through the event list, injecting a fault into corresponding chip at each event, and invoking ECC
 	for (auto time_fault_pair = q1.begin(); time_fault_pair != q1.end(); ++time_fault_pair)
@@ -217,11 +600,6 @@ uint64_t Simulation::runOne(const uint64_t max_s, int verbose, uint64_t bin_leng
 			pDRAM->dumpState();
 		}
 
-		// Peek at the future
-		auto next_pair = std::next(time_fault_pair);
-		bool scrub_before_next  = next_pair == q1.end() || floor(timestamp / m_scrub_interval) != floor(next_pair->first / m_scrub_interval);
-
-
 		// Run the repair function: This will check the correctability / detectability of the fault(s)
 		failures_t failure_count = pDRAM->get_group().repair();
 
@@ -234,24 +612,24 @@ uint64_t Simulation::runOne(const uint64_t max_s, int verbose, uint64_t bin_leng
 
 		if (failure_count.undetected || failure_count.uncorrected)
 		{
-			uint64_t bin = timestamp / bin_length;
-			fail_time_bins[bin]++;
-
-			if (failure_count.uncorrected > 0)
-				fail_uncorrectable[bin]++;
-			if (failure_count.undetected > 0)
-				fail_undetectable[bin]++;
-
-			errors++;
+			record_failure(timestamp / bin_length, failure_count, weight);
 
 			if (!m_cont_running)
 			{
 				// if any repair fails, halt the simulation and report failure
-				finalize();
-				return 1;
+				finalize(weight);
+				return weight;
 			}
 		}
 
+		// Multilevel splitting: replace the rest of this simulation by clones when it gets closer to an error
+		if (split_level < m_split_levels.size() && pDRAM->get_group().danger_level() >= m_split_levels[split_level])
+			return split(max_s, verbose, bin_length, timestamp, weight, split_level, split_path);
+
+		// Peek at the future
+		auto next_pair = std::next(time_fault_pair);
+		bool scrub_before_next  = next_pair == q1.end() || floor(timestamp / m_scrub_interval) != floor(next_pair->first / m_scrub_interval);
+
 		// Scrubbing is performed after a fault has occured and if the next fault is in a different scrub interval
 		if (!scrub_before_next)
 			continue;
@@ -262,13 +640,56 @@ uint64_t Simulation::runOne(const uint64_t max_s, int verbose, uint64_t bin_leng
 
 	/***********************************************/
 
-	// returns number of uncorrectable simulations
+	// returns the weight of the simulation if it failed
 
-	finalize();
-	if (errors > 0)
-		return 1;
-	else
-		return 0;
+	finalize(weight);
+	for (GroupDomain *fd: m_domains)
+		if (fd->getErrorCount().any())
+			return weight;
+
+	return 0.;
+}
+
+
+double Simulation::split(const uint64_t max_s, int verbose, uint64_t bin_length, double split_time, double weight,
+						 unsigned split_level, uint64_t split_path)
+{
+	std::vector<GroupDomain::snapshot_t> state(m_domains.size());
+	auto snapshot = state.begin();
+	for (GroupDomain *fd: m_domains)
+		fd->save_state(*snapshot++);
+
+	double failures = 0.;
+	for (unsigned clone = 0; clone < m_split_factor; clone++)
+	{
+		if (clone)
+		{
+			snapshot = state.begin();
+			for (GroupDomain *fd: m_domains)
+				fd->restore_state(*snapshot++);
+		}
+
+		// Give each clone independent streams, from a unique path in the tree of clones of this simulation
+		uint64_t path = split_path * m_split_factor + clone + 1;
+		uint64_t clone_seed = RandomStream::derive(m_seed, path);
+
+		for (GroupDomain *fd: m_domains)
+			fd->seed_clone(clone_seed, m_sim_index);
+		m_gen.seed(clone_seed, m_sim_index);
+
+		// Poisson processes are memoryless: the faults after the split are drawn from the same rates
+		std::vector<fault_event_t> q1;
+		generate_faults(q1, max_s, split_time + std::exponential_distribution<double>(m_fault_rate)(m_gen));
+
+		// Scrubbing that would have happened before the clone's first fault
+		if (q1.empty() || floor(split_time / m_scrub_interval) != floor(q1.front().first / m_scrub_interval))
+			for (FaultDomain *fd: m_domains)
+				fd->scrub();
+
+		failures += runOne(max_s, verbose, bin_length, q1, weight / m_split_factor, split_level + 1, path);
+	}
+
+	return failures;
 }
 
 void Simulation::printStats(uint64_t max_time)
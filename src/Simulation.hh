@@ -24,20 +24,31 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
 #include <vector>
+#include <array>
 #include <fstream>
+#include <functional>
 
 #include "FaultDomain.hh"
 #include "GroupDomain.hh"
+#include "RandomStream.hh"
+#include "AliasTable.hh"
+
+class DRAMDomain;
 
 class Simulation
 {
 public:
-	Simulation(uint64_t scrub_interval, bool debug_mode, bool cont_running, uint64_t output_bucket);
+	Simulation(uint64_t scrub_interval, bool debug_mode, bool cont_running, uint64_t output_bucket, uint64_t seed = 0);
 	~Simulation();
 	void reset();
-	void finalize();
+	void finalize(double weight = 1.);
 	void simulate(uint64_t max_time, uint64_t n_sims, int verbose, std::ofstream& output_file);
 	void addDomain(GroupDomain *domain);
+	void setThreads(unsigned n_threads, std::function<GroupDomain *()> genModule);
+	void setSkipFaultFree(bool skip);
+	void setEstimator(decltype(Settings::estimator) estimator);
+	void setImportanceBias(const std::vector<double> &bias);
+	void setSplitting(const std::vector<unsigned> &levels, unsigned factor);
 	void printStats(uint64_t max_time);
 
 protected:
@@ -45,17 +56,83 @@ protected:
 	const bool m_debug_mode;
 	const bool m_cont_running;
 	const uint64_t m_output_bucket;
+	const uint64_t m_seed;
+
+	/** Number of worker threads, and how to build each worker's own copy of the simulated module */
+	unsigned m_threads;
+	std::function<GroupDomain *()> m_genModule;
+
+	/** Whether to draw the first fault time of the whole simulation upfront, skipping the simulation if there are none */
+	bool m_skip_fault_free;
+	/** Random stream for simulation-level events */
+	RandomStream m_gen;
 
+	/** Monte Carlo estimator, see Settings::estimator */
+	decltype(Settings::estimator) m_estimator;
+	/** For the conditional estimator: the number of faults simulated is at least m_fault_threshold, which happens with
+	 * probability m_p_threshold, while simulations with faults but fewer than m_fault_threshold have probability m_p_below.
+	 * m_fault_mean is the expected number of faults in a simulation. */
+	unsigned m_fault_threshold;
+	double m_fault_mean, m_p_threshold, m_p_below;
+	/** For importance sampling: factor applied to the FIT rate of each fault class, and the likelihood ratio of a
+	 * simulation without faults, i.e. exp(-(original total rate - biased total rate) * simulated time) */
+	std::vector<double> m_is_bias;
+	double m_is_no_fault_ratio;
+	/** For multilevel splitting: simulations are cloned m_split_factor times when reaching each of the danger levels */
+	std::vector<unsigned> m_split_levels;
+	unsigned m_split_factor;
+	/** Index of the simulation being run, to seed the streams of its clones */
+	uint64_t m_sim_index;
+
+	/** The fault arrival processes: one per chip, fault class, and transient or permanent fault, with the ratio of their
+	 * original rate over the rate at which faults are sampled */
+	struct fault_source_t { DRAMDomain *chip; fault_class_t fault; bool transient; double likelihood_ratio; };
+	std::vector<fault_source_t> m_fault_sources;
+	/** Table to pick a fault arrival process proportionally to its rate */
+	AliasTable m_fault_source_table;
+	/** Total rate of sampled faults and of original faults (per second), and whether all arrival processes are Poisson */
+	double m_fault_rate, m_original_fault_rate;
+	bool m_exponential;
 
 	uint64_t stat_total_failures, stat_total_corrected, stat_total_sims;
+	double stat_weighted_failures;
 
 	std::vector<uint64_t> fail_time_bins;
 	std::vector<uint64_t> fail_uncorrectable;
 	std::vector<uint64_t> fail_undetectable;
 
+	// Histograms weighted by the probability of each simulation relative to plain Monte Carlo
+	std::vector<double> fail_time_weights;
+	std::vector<double> fail_uncorrectable_weights;
+	std::vector<double> fail_undetectable_weights;
+	// Sums over simulations of their squared weighted contributions to each bin, to estimate the variance of the histograms
+	std::vector<double> fail_time_squares;
+	std::vector<double> fail_uncorrectable_squares;
+	std::vector<double> fail_undetectable_squares;
+	// Weighted contributions of the current simulation (with all its clones) to the histograms, and the bins it touched
+	std::vector<std::array<double, 3>> sim_bin_weights;
+	std::vector<uint64_t> sim_bins;
+
 	std::list<GroupDomain *> m_domains;
 
-	virtual uint64_t runOne(uint64_t max_time, int verbose, uint64_t bin_length);
+	void run(uint64_t max_time, uint64_t first_sim, uint64_t n_sims, int verbose);
+	void merge(const Simulation &other);
+
+	typedef std::pair<double, FaultRange *> fault_event_t;
+
+	void prepare_fault_sources();
+	void prepare_estimator(uint64_t max_time);
+	double generate_faults(std::vector<fault_event_t> &q1, uint64_t max_time, double first_fault = 0.);
+	void generate_n_faults(std::vector<fault_event_t> &q1, uint64_t max_time, uint64_t n_faults);
+	uint64_t draw_fault_count();
+
+	void record_failure(uint64_t bin, const failures_t &failure_count, double weight);
+	void close_sim_bins();
+
+	virtual double runOne(uint64_t max_time, int verbose, uint64_t bin_length, std::vector<fault_event_t> &q1,
+						  double weight = 1., unsigned split_level = 0, uint64_t split_path = 0);
+	double split(uint64_t max_time, int verbose, uint64_t bin_length, double split_time, double weight,
+				 unsigned split_level, uint64_t split_path);
 };
 
 
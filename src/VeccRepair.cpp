@@ -33,6 +33,8 @@ VeccRepair::VeccRepair(std::string name, int n_sym_correct, int n_sym_detect, in
 	, m_n_correct(n_sym_correct), m_n_detect(n_sym_detect)
 	, m_n_additional(n_sym_added), m_protected_fraction(protected_fraction)
 	, m_unprotected_swtol(DRAM_MAX, 0.), m_protected_swtol(DRAM_MAX, 0.)
+	, tier2_gen(RandomStream::GROUP, RandomStream::TIER2_LOCATIONS)
+	, protection_gen(RandomStream::GROUP, RandomStream::PROTECTED_ROWS), m_data_chips()
 {
 	assert(protected_fraction >= 0. && protected_fraction <= 1.);
 }
@@ -62,18 +64,24 @@ failures_t VeccRepair::repair(FaultDomain *fd)
 
 	assert(dd->chips() == (1 << log2_data_chips) + 2 * m_n_correct);
 
-	auto predicate = [this](FaultIntersection &error) { return error.chip_count() > m_n_correct; };
+	auto predicate = [this](auto &error) { return error.chip_count() > m_n_correct; };
 
-	std::list<FaultIntersection>& failures = dd->intersecting_ranges(symbol_bits, predicate);
+	std::vector<FaultIntersection *>& failures = dd->intersecting_ranges(symbol_bits, predicate, m_n_correct + 1);
+
+	// NB: only data chips used for Tier2 VECC to allow partial writes
+	m_data_chips.resize(1ULL << log2_data_chips);
+	for (FaultDomain *fd: dd->getChildren())
+	{
+		DRAMDomain *dram = dynamic_cast<DRAMDomain*>(fd);
+		if (dram->getChipNum() < m_data_chips.size())
+			m_data_chips[dram->getChipNum()] = &dram->getRanges();
+	}
 
 	failures_t count = {0, 0};
-	for (auto fail = failures.begin(); fail != failures.end(); )
+	for (FaultIntersection *fail: failures)
 	{
 		if (check_tier2(dd, *fail))
-		{
-			fail = failures.erase(fail);
-			continue;
-		}
+			fail->mark_corrected();
 		else if (fail->chip_count() > m_n_detect)
 		{
 			fail->mark_undetectable();
@@ -84,7 +92,6 @@ failures_t VeccRepair::repair(FaultDomain *fd)
 			fail->mark_uncorrectable();
 			count.uncorrected++;
 		}
-		++fail;
 	}
 
 	return count;
@@ -107,16 +114,15 @@ bool VeccRepair::check_tier2(GroupDomain_dimm *dd, FaultIntersection& error)
 
 	// TODO: implement a realistic evaluation for m_protection_fraction == 1.
 
-	// TODO: remember pages that were protected
-	if (distribution(gen) > m_protected_fraction)
+	// Rows are protected or not for the whole simulation
+	if (!is_protected(chip, error.fAddr))
 		return try_sw_tolerance(error, m_unprotected_swtol);
 
-	// Get a random location in a (the?) other rank, where the supplementary symbols (tier 2 ECC) for this DRAM row is stored
-	FaultRange *tier2 = chip->genRandomRange(DRAM_1BIT, true);
-	chip->put<Ranks>(tier2->fAddr, chip->get<Ranks>(error.fAddr) + 1);
+	// Get the location in a (the?) other rank, where the supplementary symbols (tier 2 ECC) for this DRAM row are stored
+	uint64_t tier2_addr = tier2_address(chip, error.fAddr);
 
 	// 1 chip = 1 symbol (at least for amount of redundancy purposes) = dd->burst_size() / data_chips
-	const size_t data_chips = 1ULL << static_cast<int>(floor(log2(dd->chips())));
+	const size_t data_chips = m_data_chips.size();
 	const size_t t2sym_size = dd->burst_size() / data_chips;
 	const size_t error_size = std::max(dd->burst_size(), (error.fWildMask + 1) * data_chips);
 
@@ -124,9 +130,11 @@ bool VeccRepair::check_tier2(GroupDomain_dimm *dd, FaultIntersection& error)
 	const size_t t2err_size = t2cl_size * (error_size / dd->burst_size());
 
 	// get the per-chip positions/masks right
-	const size_t start = tier2->fAddr & ~(t2err_size / data_chips - 1), end = start + t2err_size / data_chips;
-	tier2->fWildMask = (t2sym_size / data_chips - 1);
-	auto find_intersecting_tier2 = [tier2](FaultRange *fr) { return tier2->intersects(fr); };
+	const size_t start = tier2_addr & ~(t2err_size / data_chips - 1), end = start + t2err_size / data_chips;
+	const uint64_t tier2_mask = (t2sym_size / data_chips - 1);
+
+	const ChipOccupancy &occupancy = dd->occupancy();
+	const uint64_t data_chips_mask = data_chips < 64 ? (1ULL << data_chips) - 1 : ~0ULL;
 
 	// Iterate over all the cache lines in the fault range
 	for (size_t addr = start; addr != end; addr += t2cl_size / data_chips)
@@ -135,18 +143,16 @@ bool VeccRepair::check_tier2(GroupDomain_dimm *dd, FaultIntersection& error)
 		// decrement for every failed symbol: if < 0 we have an uncorrectable fault
 		int allowance = m_n_correct + m_n_additional - error.chip_count();
 
-		for (uint64_t symbol = 0; symbol < 2 * m_n_additional; tier2->fAddr += t2sym_size / data_chips, ++symbol)
+		for (uint64_t symbol = 0; symbol < 2 * m_n_additional; tier2_addr += t2sym_size / data_chips, ++symbol)
 		{
-			for (auto chip: dd->getChildren())
-			{
-				DRAMDomain *dram = dynamic_cast<DRAMDomain*>(chip);
+			// only the chips with faults in the bank of the symbol can corrupt it
+			uint64_t candidates = occupancy.empty() ? data_chips_mask
+								  : occupancy.chips(chip->get<Ranks>(tier2_addr), chip->get<Banks>(tier2_addr)) & data_chips_mask;
 
-				// NB: only data chips used for Tier2 VECC to allow partial writes
-				if (dram->getChipNum() >= data_chips)
-					continue;
-
-				std::list<FaultRange *> list = dram->getRanges();
-				if (std::find_if(list.begin(), list.end(), find_intersecting_tier2) != list.end())
+			for (; candidates; candidates &= candidates - 1)
+			{
+				const FaultStore &faults = *m_data_chips[__builtin_ctzll(candidates)];
+				if (faults.find_intersecting(tier2_addr, tier2_mask) != faults.size())
 				{
 					allowance--;
 					break;
@@ -32,6 +32,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "DRAMDomain.hh"
 #include "GroupDomain_dimm.hh"
 #include "ChipKillRepair.hh"
+#include "RandomStream.hh"
 
 
 class SoftwareTolerance : public RepairScheme
@@ -39,15 +40,16 @@ class SoftwareTolerance : public RepairScheme
 protected:
 	std::vector<double> m_swtol;
 
-	mutable std::mt19937_64 gen;
-	std::uniform_real_distribution<double> distribution;
+	/** Random numbers indexed by the location of errors, rather than drawn in sequence */
+	RandomStream gen;
 
+	/** Whether software tolerates an error, always the same for a location and a probability within a simulation */
 	inline
-	bool try_sw_tolerance(FaultIntersection &error, std::vector<double> swtol)
+	bool try_sw_tolerance(FaultIntersection &error, const std::vector<double> &swtol)
 	{
-		// TODO: memoize redundant locations
 		fault_class_t cls = error.m_pDRAM->maskClass(error.fWildMask);
-		return /*!it->transient && */ distribution(gen) < swtol.at(cls);
+		const uint64_t location_number = gen.at(error.fAddr & ~error.fWildMask, error.fWildMask);
+		return /*!it->transient && */ RandomStream::uniform(location_number) < swtol.at(cls);
 	}
 
 	inline
@@ -59,28 +61,32 @@ protected:
 public:
 	SoftwareTolerance(std::string name, std::vector<double> tolerating_probability)
 		: RepairScheme(name)
-		, m_swtol(tolerating_probability), gen(), distribution(0., 1.)
+		, m_swtol(tolerating_probability), gen(RandomStream::GROUP, RandomStream::SW_TOLERANCE)
 	{
 		assert(m_swtol.size() == DRAM_MAX);
 	}
 
+	void seed(uint64_t global_seed, uint64_t sim_index)
+	{
+		gen.seed(global_seed, sim_index);
+	}
+
+	/** Whether errors are tolerated stays decided by the simulation being split */
+	void seed_clone(uint64_t clone_seed [[gnu::unused]], uint64_t sim_index [[gnu::unused]]) {}
+
 	failures_t repair(FaultDomain *fd)
 	{
 		GroupDomain_dimm *dd = dynamic_cast<GroupDomain_dimm *>(fd);
-		std::list<FaultIntersection>& failures = dd->intersecting_ranges(log2(dd->burst_size()));
+		std::vector<FaultIntersection *>& failures = dd->intersecting_ranges(log2(dd->burst_size()));
 		failures_t remaining = {0, 0};
 
-		for (auto it = failures.begin(); it != failures.end();)
-			if (try_sw_tolerance(*it))
-				it = failures.erase(it);
+		for (FaultIntersection *fail: failures)
+			if (try_sw_tolerance(*fail))
+				fail->mark_corrected();
+			else if (fail->detected())
+				remaining.uncorrected++;
 			else
-			{
-				if (it->detected())
-					remaining.uncorrected++;
-				else
-					remaining.undetected++;
-				++it;
-			}
+				remaining.undetected++;
 
 		return remaining;
 	}
@@ -103,13 +109,60 @@ public:
 
 	failures_t repair(FaultDomain *fd);
 
+	unsigned failure_threshold() const
+	{
+		return m_n_correct + 1;
+	}
+
 	void allow_software_tolerance(std::vector<double> tolerating_probability, std::vector<double> unprotected_tolerating_probability);
 
+	void seed(uint64_t global_seed, uint64_t sim_index)
+	{
+		SoftwareTolerance::seed(global_seed, sim_index);
+		tier2_gen.seed(global_seed, sim_index);
+		protection_gen.seed(global_seed, sim_index);
+	}
+
 private:
 	const uint64_t m_n_correct, m_n_detect, m_n_additional;
 	const double m_protected_fraction;
 	std::vector<double> m_unprotected_swtol, m_protected_swtol;
 
+	/** Placement of the tier-2 symbols of each DRAM row, and whether the row is protected, fixed for a simulation and its clones */
+	RandomStream tier2_gen, protection_gen;
+
+	/** Faults of the data chips, indexed by their position in the rank */
+	std::vector<const FaultStore *> m_data_chips;
+
+	/** Index of the DRAM row at an address, over all the ranks and banks of the chip */
+	inline
+	uint32_t row_index(DRAMDomain *chip, uint64_t address) const
+	{
+		return (chip->get<Ranks>(address) * chip->getNum<Banks>() + chip->get<Banks>(address)) * chip->getNum<Rows>()
+			   + chip->get<Rows>(address);
+	}
+
+	/** Whether the DRAM row at an address has the extended protection, which a fraction m_protected_fraction of rows has */
+	inline
+	bool is_protected(DRAMDomain *chip, uint64_t address) const
+	{
+		return RandomStream::uniform(protection_gen.at(row_index(chip, address))) < m_protected_fraction;
+	}
+
+	/** Address in the next rank where the tier-2 symbols of the DRAM row at row_address are stored */
+	inline
+	uint64_t tier2_address(DRAMDomain *chip, uint64_t row_address) const
+	{
+		const uint64_t location = tier2_gen.at(row_index(chip, row_address));
+
+		uint64_t address = 0;
+		chip->put<Ranks>(address, chip->get<Ranks>(row_address) + 1);
+		chip->put<Banks>(address, location % chip->getNum<Banks>());
+		chip->put<Rows>(address, (location >> 16) % chip->getNum<Rows>());
+		chip->put<Cols>(address, (location >> 40) % chip->getNum<Cols>());
+		return address;
+	}
+
 	inline
 	uint64_t get_row_address(FaultRange *fr)
 	{
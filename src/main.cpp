@@ -50,12 +50,14 @@ int main(int argc, char **argv)
 	po::options_description desc("Options");
 	std::string config_file, output_file;
 	std::vector<std::string> config_overrides;
+	unsigned n_threads;
 
 	desc.add_options()
 		("help,h", "Print help messages")
 		("config,c", po::value<std::vector<std::string>>(&config_overrides), "Manually specify configuration file items as section.key=value")
 		("outfile,o", po::value<std::string>(&output_file)->required(), "Output file name")
-		("inifile,i", po::value<std::string>(&config_file), "Indicate .ini configuration file to use");
+		("inifile,i", po::value<std::string>(&config_file), "Indicate .ini configuration file to use")
+		("threads,t", po::value<unsigned>(&n_threads)->default_value(1), "Number of threads running simulations");
 
 	po::positional_options_description pd;
 	pd.add("inifile", 1).add("outfile", 1);
@@ -96,12 +98,17 @@ int main(int argc, char **argv)
 	}
 
 	// Build the physical memory organization and attach ECC scheme /////
-	GroupDomain *module = NULL;
+	// genModule() may consume some settings, so always build from a copy, which allows building one module per thread.
+	auto genModule = [] () -> GroupDomain *
+	{
+		Settings module_settings = settings;
+		if (module_settings.organization == Settings::DIMM)
+			return GroupDomain_dimm::genModule(module_settings, 0);
+		else
+			return GroupDomain_cube::genModule(module_settings, 0);
+	};
 
-	if (settings.organization == Settings::DIMM)
-		module = GroupDomain_dimm::genModule(settings, 0);
-	else
-		module = GroupDomain_cube::genModule(settings, 0);
+	GroupDomain *module = genModule();
 
 	// Configure simulator ///////////////////////////////////////////////
 	// Simulator settings are as follows:
@@ -110,10 +117,17 @@ int main(int argc, char **argv)
 	// c. The setting.continue_running will enable users to continue running even if an uncorrectable error occurs
 	//    (until an undetectable error occurs).
 	// d. The settings.output_bucket_s will bucket system failure times
+	// e. The settings.seed selects the random streams, which are per-simulation and thus independent of n_threads
 
-	Simulation sim(settings.scrub_s, settings.debug, settings.continue_running, settings.output_bucket_s);
+	Simulation sim(settings.scrub_s, settings.debug, settings.continue_running, settings.output_bucket_s, settings.seed);
 
 	sim.addDomain(module);       // register the top-level memory object with the simulation engine
+	sim.setThreads(n_threads, genModule);
+	sim.setSkipFaultFree(settings.skip_fault_free);
+	sim.setEstimator(settings.estimator);
+	sim.setImportanceBias(settings.is_bias);
+	if (settings.estimator == Settings::SPLITTING)
+		sim.setSplitting(settings.split_levels, settings.split_factor);
 
 	// Run simulator //////////////////////////////////////////////////
 	sim.simulate(settings.max_s, settings.n_sims, settings.verbose, opfile);
@@ -79,4 +79,36 @@ BOOST_AUTO_TEST_CASE( ChipKill_DRAM_1rank_1bit )
 	domain->reset();
 }
 
+BOOST_AUTO_TEST_CASE( ChipKill_DRAM_indexed_intersections )
+{
+	// Enough faults for intersecting_ranges() to look up candidates in its rank/bank/row index
+	std::vector<FaultRange *> bits;
+	for (unsigned i = 0; i < 40; i++)
+	{
+		bits.push_back(chips[0]->genRandomRange(DRAM_1BIT, false));
+		if (i != 0)
+		{
+			copy<Banks>(bits.front(), bits.back());
+			diff<Rows>(bits.front(), bits.back(), i);
+		}
+		chips[0]->insertFault(bits.back());
+	}
+
+	// A row fault hitting a single of these bits, and a column fault (indexed as a wildcard) in another bank
+	FaultRange *row = chips[1]->genRandomRange(DRAM_1ROW, false);
+	copy<Banks>(bits[17], row);
+	copy<Rows>(bits[17], row);
+	chips[1]->insertFault(row);
+
+	FaultRange *col = chips[2]->genRandomRange(DRAM_1COL, false);
+	diff<Banks>(bits.front(), col);
+	chips[2]->insertFault(col);
+
+	auto &failures = domain->intersecting_ranges(log2(symbol_size), [] (auto &f) { return f.chip_count() > 1; });
+	BOOST_REQUIRE_EQUAL( failures.size(), 1 );
+	BOOST_CHECK( chips[0]->get<Rows>(failures.front()->fAddr) == chips[0]->get<Rows>(bits[17]->fAddr) );
+
+	domain->reset();
+}
+
 };
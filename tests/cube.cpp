@@ -0,0 +1,229 @@
+#include <boost/test/unit_test.hpp>
+
+#include "dram_common.hh"
+#include "Settings.hh"
+#include "FaultDomain.hh"
+#include "DRAMDomain.hh"
+#include "GroupDomain_cube.hh"
+#include "ChipKillRepair_cube.hh"
+#include "BCHRepair_cube.hh"
+#include "CubeRAIDRepair.hh"
+
+#include "utils.hh"
+
+namespace cube
+{
+
+Settings settings(bool horizontal)
+{
+	Settings settings {};
+
+	settings.organization = Settings::STACK_3D;
+
+	settings.chips_per_rank = 8;
+	settings.chip_bus_bits = 4;
+	settings.ranks = 1;
+	settings.banks = 8;
+	settings.rows = 16384;
+	settings.cols = 2048;
+	settings.data_block_bits = 512;
+
+	settings.cube_model = horizontal ? Settings::HORIZONTAL : Settings::VERTICAL;
+	settings.cube_addr_dec_depth = 0;
+	settings.cube_ecc_tsv = 0;
+	settings.cube_redun_tsv = 0;
+
+	settings.repairmode = Settings::DDC;  // Data Device Correct
+	settings.correct = 1;
+    settings.detect = 2;
+
+	settings.faultmode = Settings::JAGUAR;
+	settings.fit_factor = 0.;
+	settings.scf_factor = 0.;
+	settings.tsv_fit = 0.;
+	settings.enable_tsv = false;
+	settings.enable_transient = false;
+	settings.enable_permanent = false;
+	settings.fit_transient = {14.2, 1.4, 1.4, 0.2, 0.8, 0.3, 0.9};
+	settings.fit_permanent = {18.6, 0.3, 5.6, 8.2, 10.0, 1.4, 2.8};
+
+	settings.sw_tol = {0., 0., 0., 0., 0., 0., 0.};
+
+	return settings;
+}
+
+Settings bch_settings()
+{
+	Settings settings = cube::settings(false);
+
+	settings.repairmode = Settings::BCH;
+	settings.correct = 6;
+	settings.detect = 7;
+
+	return settings;
+}
+
+Settings raid_settings()
+{
+	Settings settings = cube::settings(false);
+
+	settings.repairmode = Settings::RAID;
+
+	return settings;
+}
+
+Settings vertical_conf = settings(false), horizontal_conf = settings(true), bch_conf = bch_settings(), raid_conf = raid_settings();
+std::unique_ptr<GroupDomain_cube> vertical {GroupDomain_cube::genModule(vertical_conf, 0)};
+std::unique_ptr<GroupDomain_cube> horizontal {GroupDomain_cube::genModule(horizontal_conf, 0)};
+std::unique_ptr<GroupDomain_cube> bch {GroupDomain_cube::genModule(bch_conf, 0)};
+std::unique_ptr<GroupDomain_cube> raid {GroupDomain_cube::genModule(raid_conf, 0)};
+
+
+
+BOOST_AUTO_TEST_CASE( ChipKill_cube_1chip_banks )
+{
+	// A fault in all the banks of a chip is a single symbol per codeword only if codewords span chips
+	for (GroupDomain_cube *domain: {vertical.get(), horizontal.get()})
+	{
+		std::vector<DRAMDomain *> chips = get_chips(*domain);
+		chips[0]->insertFault(chips[0]->genRandomRange(DRAM_NBANK, false));
+
+		BOOST_CHECK( domain->repair().any() == domain->horizontalTSV() );
+
+		domain->reset();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ChipKill_cube_failure_threshold )
+{
+	// The conditional estimator only simulates as many faults as the threshold, so a single fault that fails needs it at 1
+	for (GroupDomain_cube *domain: {vertical.get(), horizontal.get()})
+	{
+		std::vector<DRAMDomain *> chips = get_chips(*domain);
+		chips[0]->insertFault(chips[0]->genRandomRange(DRAM_NBANK, false));
+
+		BOOST_CHECK( domain->repair().any() == (domain->failure_threshold() == 1) );
+		BOOST_CHECK( domain->failure_threshold() == (domain->horizontalTSV() ? 1 : vertical_conf.correct + 1) );
+
+		domain->reset();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ChipKill_cube_2chips_same_bit )
+{
+	// The same bit in 2 chips is 2 symbols of a codeword only if codewords span chips
+	for (GroupDomain_cube *domain: {vertical.get(), horizontal.get()})
+	{
+		std::vector<DRAMDomain *> chips = get_chips(*domain);
+		FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, false);
+		FaultRange *fr1 = new FaultRange(*fr0);
+
+		chips[0]->insertFault(fr0);
+		chips[1]->insertFault(fr1);
+
+		BOOST_CHECK( domain->repair().any() == !domain->horizontalTSV() );
+
+		domain->reset();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ChipKill_cube_2banks_same_bit )
+{
+	// The same bit in 2 banks of a chip is 2 symbols of a codeword only if codewords span banks
+	for (GroupDomain_cube *domain: {vertical.get(), horizontal.get()})
+	{
+		std::vector<DRAMDomain *> chips = get_chips(*domain);
+		FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, false);
+		FaultRange *fr1 = new FaultRange(*fr0);
+		diff<Banks>(fr0, fr1);
+
+		chips[0]->insertFault(fr0);
+		chips[0]->insertFault(fr1);
+
+		BOOST_CHECK( domain->repair().any() == domain->horizontalTSV() );
+
+		domain->reset();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( BCH_cube_col_narrowed_to_row )
+{
+	std::vector<DRAMDomain *> chips = get_chips(*bch);
+	// the stack caps its failures to its fault count, the scheme itself counts the bits beyond correction
+	BCHRepair_cube scheme("6EC7ED", bch_conf.correct, bch_conf.detect, bch_conf.data_block_bits);
+
+	// A column fault on one DQ, and word faults in 2 rows of the same block of columns
+	FaultRange *col = chips[0]->genRandomRange(DRAM_1COL, false);
+	chips[0]->put<Cols>(col->fAddr, 5);
+	chips[0]->put<Bits>(col->fAddr, 1);
+	chips[0]->put<Bits>(col->fWildMask, 0);
+
+	FaultRange *word0 = chips[0]->genRandomRange(DRAM_1WORD, false), *word1 = chips[0]->genRandomRange(DRAM_1WORD, false);
+	for (FaultRange *word: {word0, word1})
+	{
+		copy<Ranks>(col, word);
+		copy<Banks>(col, word);
+	}
+	chips[0]->put<Rows>(word0->fAddr, 3);
+	chips[0]->put<Cols>(word0->fAddr, 10);
+	chips[0]->put<Rows>(word1->fAddr, 7);
+	chips[0]->put<Cols>(word1->fAddr, 20);
+
+	chips[0]->insertFault(col);
+	chips[0]->insertFault(word0);
+	chips[0]->insertFault(word1);
+
+	// The column's block is narrowed to the row of the first word: 1 + 4 bits are corrected, not the 1 + 2 * 4 of both rows
+	BOOST_CHECK( bch->repair().any() == false );
+	BOOST_CHECK( scheme.repair(bch.get()).uncorrected == 0 );
+
+	// A row fault on another DQ, whose bits come first in the column's block: narrowed to that row, 128 + 1 bits
+	FaultRange *row = chips[0]->genRandomRange(DRAM_1ROW, false);
+	copy<Ranks>(col, row);
+	copy<Banks>(col, row);
+	chips[0]->put<Rows>(row->fAddr, 11);
+	chips[0]->put<Bits>(row->fAddr, 0);
+	chips[0]->put<Bits>(row->fWildMask, 0);
+	chips[0]->insertFault(row);
+
+	BOOST_CHECK( bch->repair().any() == true );
+
+	failures_t fail = scheme.repair(bch.get());
+	BOOST_CHECK( fail.uncorrected == 128 + 1 - bch_conf.correct );
+	BOOST_CHECK( fail.undetected == 0 );
+
+	bch->reset();
+}
+
+BOOST_AUTO_TEST_CASE( RAID_cube_chip_intersections )
+{
+	std::vector<DRAMDomain *> chips = get_chips(*raid);
+	CubeRAIDRepair scheme("RAID", raid_conf.correct, raid_conf.detect, raid_conf.data_block_bits);
+
+	// A bit fault and a word fault over it in the same chip are a single chip of the block
+	FaultRange *bit = chips[0]->genRandomRange(DRAM_1BIT, false);
+	FaultRange *word = new FaultRange(*bit);
+	chips[0]->put<Bits>(word->fWildMask, ~0);
+	chips[0]->insertFault(bit);
+	chips[0]->insertFault(word);
+
+	BOOST_CHECK( raid->repair().any() == false );
+	BOOST_CHECK( scheme.repair(raid.get()).uncorrected == 0 );
+
+	// A fault over all the banks of another chip, which has no fixed bank or row to be sorted by, intersects them
+	chips[2]->insertFault(chips[2]->genRandomRange(DRAM_NBANK, false));
+
+	BOOST_CHECK( raid->repair().any() == true );
+	BOOST_CHECK( scheme.repair(raid.get()).uncorrected == 1 );
+	// the bit of the first chip already fails, through the faults that are not sorted
+	BOOST_CHECK( bit->transient_remove == false );
+
+	// The same bit in a third chip, found by its rank, bank and row
+	chips[1]->insertFault(new FaultRange(*bit));
+
+	BOOST_CHECK( scheme.repair(raid.get()).uncorrected == 2 );
+
+	raid->reset();
+}
+
+};
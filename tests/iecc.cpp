@@ -71,8 +71,8 @@ BOOST_AUTO_TEST_CASE( IECC_DRAM_2bit_separate )
 	FaultRange *fr1 = new FaultRange(*fr0);
 
 	// Inject in the next IECC codeword
-	unsigned wordsize = (conf.iecc_codeword - conf.iecc_dataword) / chips[0]->getNum<Bits>();
-	diff<Cols>(fr0, fr1, wordsize);
+	unsigned codeword_cols = conf.iecc_codeword / chips[0]->getNum<Bits>();
+	diff<Cols>(fr0, fr1, codeword_cols);
 
 	chips[0]->insertFault(fr0);
 	chips[0]->insertFault(fr1);
@@ -88,23 +88,21 @@ BOOST_AUTO_TEST_CASE( IECC_DRAM_2bit_codeword )
 	FaultRange *fr1 = new FaultRange(*fr0);
 
 	// Inject in the same IECC codeword
-	unsigned wordsize = (conf.iecc_codeword - conf.iecc_dataword) / chips[0]->getNum<Bits>();
+	unsigned codeword_cols = conf.iecc_codeword / chips[0]->getNum<Bits>();
 	unsigned col = chips[0]->get<Cols>(fr0->fAddr);
 
-	unsigned word = col / wordsize, pos = col % wordsize;
-	chips[0]->put<Cols>(fr1->fAddr, word * wordsize + (pos + 1) % wordsize);
-
-	FaultIntersection fi0(fr0, 127);
-	FaultIntersection fi1(fr1, 127);
-	fi0.intersection(fi1);
-
-	BOOST_CHECK( fi0.bit_count_aggregate(128) == 2 );
+	unsigned word = col / codeword_cols, pos = col % codeword_cols;
+	chips[0]->put<Cols>(fr1->fAddr, word * codeword_cols + (pos + 1) % codeword_cols);
 
 	chips[0]->insertFault(fr0);
 	chips[0]->insertFault(fr1);
 
 	BOOST_CHECK( domain->repair().any() == true );
 
+	// both faults make a single uncorrectable error
+	BOOST_REQUIRE( chips[0]->getRanges().size() == 1 );
+	BOOST_CHECK( dynamic_cast<FaultIntersection *>(chips[0]->getRanges()[0])->chip_count() == 2 );
+
 	domain->reset();
 }
 
@@ -113,17 +111,12 @@ BOOST_AUTO_TEST_CASE( IECC_DRAM_2x_same_1bit )
 	FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, false);
 	FaultRange *fr1 = new FaultRange(*fr0);
 
-	FaultIntersection fi0(fr0, 127);
-	FaultIntersection fi1(fr1, 127);
-	fi0.intersection(fi1);
-
-	BOOST_CHECK( fi0.bit_count_aggregate(128) == 1 );
-
 	// twice the same 1BIT fault should be correctable
 	chips[0]->insertFault(fr0);
 	chips[0]->insertFault(fr1);
 
 	BOOST_CHECK( domain->repair().any() == false );
+	BOOST_CHECK( chips[0]->getRanges().empty() );
 
 	domain->reset();
 }
@@ -135,18 +128,83 @@ BOOST_AUTO_TEST_CASE( IECC_DRAM_1bit_1col )
 	chips[0]->put<Rows>(fr1->fWildMask, 0);
 	chips[0]->put<Bits>(fr1->fWildMask, 0);
 
-	FaultIntersection fi0(fr0, 127);
-	FaultIntersection fi1(fr1, 127);
-	fi0.intersection(fi1);
+	// Inject in the same IECC codeword
+	chips[0]->insertFault(fr0);
+	chips[0]->insertFault(fr1);
 
-	BOOST_CHECK( fi0.bit_count_aggregate(128) == chips[0]->getNum<Cols>() );
+	BOOST_CHECK( domain->repair().any() == true );
+
+	// the column fails in all rows, which covers the codeword of the bit fault's row
+	BOOST_REQUIRE( chips[0]->getRanges().size() == 1 );
+	BOOST_CHECK( !chips[0]->has<Rows>(chips[0]->getRanges().mask(0)) );
+
+	domain->reset();
+}
+
+BOOST_AUTO_TEST_CASE( IECC_DRAM_1col_1word )
+{
+	// A column fault of a single bit is correctable in every row
+	FaultRange *col = chips[0]->genRandomRange(DRAM_1COL, false);
+	chips[0]->put<Bits>(col->fWildMask, 0);
+	chips[0]->insertFault(col);
+
+	BOOST_CHECK( domain->repair().any() == false );
+
+	// A word fault in the same codeword of one row, in another column
+	unsigned codeword_cols = conf.iecc_codeword / chips[0]->getNum<Bits>();
+	unsigned col_addr = chips[0]->get<Cols>(col->fAddr);
+
+	FaultRange *word = chips[0]->genRandomRange(DRAM_1WORD, false);
+	copy<Ranks>(col, word);
+	copy<Banks>(col, word);
+	chips[0]->put<Cols>(word->fAddr, col_addr / codeword_cols * codeword_cols + (col_addr + 1) % codeword_cols);
+	chips[0]->insertFault(word);
+
+	BOOST_CHECK( domain->repair().any() == true );
+
+	// only the codeword of that row fails, with both faults
+	BOOST_REQUIRE( chips[0]->getRanges().size() == 1 );
+	FaultRange *error = chips[0]->getRanges()[0];
+	BOOST_CHECK( chips[0]->has<Rows>(error->fWildMask) );
+	BOOST_CHECK( chips[0]->get<Rows>(error->fAddr) == chips[0]->get<Rows>(word->fAddr) );
+	BOOST_CHECK( dynamic_cast<FaultIntersection *>(error)->chip_count() == 2 );
+
+	// A bit fault on the column's bit in another row adds no wrong bit to its codeword
+	FaultRange *bit = new FaultRange(*col);
+	chips[0]->put<Rows>(bit->fWildMask, 0);
+	chips[0]->put<Rows>(bit->fAddr, (chips[0]->get<Rows>(word->fAddr) + 1) % chips[0]->getNum<Rows>());
+	chips[0]->insertFault(bit);
+
+	BOOST_CHECK( domain->repair().any() == true );
+	BOOST_CHECK( chips[0]->getRanges().size() == 1 );
+
+	domain->reset();
+}
+
+BOOST_AUTO_TEST_CASE( IECC_DRAM_scrub_1bit )
+{
+	FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, false);
+	FaultRange *fr1 = chips[0]->genRandomRange(DRAM_1BIT, true);
+	copy<Ranks>(fr0, fr1);
+	copy<Banks>(fr0, fr1);
+	copy<Rows>(fr0, fr1);
+
+	// A permanent and a transient bit fault in the same IECC codeword
+	unsigned codeword_cols = conf.iecc_codeword / chips[0]->getNum<Bits>();
+	unsigned col = chips[0]->get<Cols>(fr0->fAddr);
+	chips[0]->put<Cols>(fr1->fAddr, col / codeword_cols * codeword_cols + (col + 1) % codeword_cols);
 
-	// Inject in the same IECC codeword
 	chips[0]->insertFault(fr0);
 	chips[0]->insertFault(fr1);
 
 	BOOST_CHECK( domain->repair().any() == true );
 
+	// once the transient fault is scrubbed, the codeword is correctable again
+	domain->scrub();
+
+	BOOST_CHECK( domain->repair().any() == false );
+	BOOST_CHECK( chips[0]->getRanges().empty() );
+
 	domain->reset();
 }
 
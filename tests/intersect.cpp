@@ -0,0 +1,38 @@
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include "IntersectKernel.hh"
+
+namespace intersect_kernel
+{
+
+BOOST_AUTO_TEST_CASE( Intersect_kernels_agree )
+{
+	const auto &kernels = intersect_kernels();
+	BOOST_REQUIRE( !kernels.empty() );
+
+	// Few address bits and wide masks, so that both hits and misses are frequent
+	std::mt19937_64 gen(1);
+	uint64_t addrs[64], masks[64];
+	for (int trial = 0; trial < 200; trial++)
+	{
+		for (int i = 0; i < 64; i++)
+		{
+			addrs[i] = gen() & 0xFF;
+			masks[i] = gen() & gen() & 0xFF;
+			addrs[i] &= ~masks[i];
+		}
+		uint64_t address = gen() & 0xFF, wildmask = gen() & gen() & 0xFF;
+
+		for (size_t n = 0; n <= 64; n++)
+		{
+			uint64_t expected = kernels.front().second(addrs, masks, n, address, wildmask);
+			for (auto &kernel: kernels)
+				BOOST_CHECK_MESSAGE( kernel.second(addrs, masks, n, address, wildmask) == expected,
+						kernel.first << " kernel with " << n << " ranges" );
+		}
+	}
+}
+
+}
@@ -2,6 +2,7 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include <memory>
+#include <tuple>
 
 #include "dram_common.hh"
 #include "Settings.hh"
@@ -73,7 +74,7 @@ BOOST_AUTO_TEST_CASE( noECC_DRAM_1fault )
 
 	BOOST_CHECK( err.size() == 1 );
 
-	err.erase(err.begin());
+	err.front()->mark_corrected();
 
 	BOOST_CHECK( domain->intersecting_ranges(symbol_size).size() == 0 );
 
@@ -100,6 +101,59 @@ BOOST_AUTO_TEST_CASE( noECC_DRAM_2faults_intersecting )
 	domain->reset();
 }
 
+BOOST_AUTO_TEST_CASE( noECC_DRAM_selection_keeps_failures )
+{
+	domain->reset();
+
+	FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, true);
+	FaultRange *fr1 = new FaultRange(*fr0);
+
+	chips[0]->insertFault(fr0);
+	chips[1]->insertFault(fr1);
+
+	// both single faults and their intersection
+	BOOST_CHECK( domain->intersecting_ranges(1).size() == 3 );
+
+	// selecting some failures keeps the others for the next repair schemes
+	BOOST_CHECK( domain->intersecting_ranges(1, [] (auto &f) { return f.chip_count() >= 2; }).size() == 1 );
+	BOOST_CHECK( domain->intersecting_ranges(1).size() == 3 );
+
+	domain->reset();
+}
+
+BOOST_AUTO_TEST_CASE( noECC_DRAM_selection_marks_failures )
+{
+	domain->reset();
+
+	FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1BIT, true);
+	FaultRange *fr1 = new FaultRange(*fr0);
+
+	chips[0]->insertFault(fr0);
+	chips[1]->insertFault(fr1);
+
+	// a first scheme marks all failures, then a scheme with another symbol size selects and marks the 2-chip failure
+	for (FaultIntersection *f: domain->intersecting_ranges(2))
+		f->mark_uncorrectable();
+
+	auto &selected = domain->intersecting_ranges(1, [] (auto &f) { return f.chip_count() >= 2; });
+	BOOST_REQUIRE( selected.size() == 1 );
+	selected.front()->mark_undetectable();
+
+	// the next scheme sees the outcomes of both
+	auto &failures = domain->intersecting_ranges(3);
+	BOOST_REQUIRE( failures.size() == 3 );
+	for (FaultIntersection *f: failures)
+		BOOST_CHECK( f->detected() == (f->chip_count() == 1) );
+
+	// and failures it tolerates are left out for the schemes after it
+	for (FaultIntersection *f: failures)
+		if (f->chip_count() == 1)
+			f->mark_corrected();
+	BOOST_CHECK( domain->intersecting_ranges(3).size() == 1 );
+
+	domain->reset();
+}
+
 BOOST_AUTO_TEST_CASE( noECC_DRAM_2faults_different )
 {
 	domain->reset();
@@ -121,4 +175,125 @@ BOOST_AUTO_TEST_CASE( noECC_DRAM_2faults_different )
 	domain->reset();
 }
 
+BOOST_AUTO_TEST_CASE( noECC_intersection_of_many_faults )
+{
+	domain->reset();
+
+	// More faults than a FaultIntersection stores inline, alternating 1-bit and 1-word faults
+	FaultRange *fr0 = chips[0]->genRandomRange(DRAM_1WORD, false);
+	FaultIntersection error(fr0, 0);
+	size_t wrong_bits = __builtin_popcount(fr0->fWildMask & 3) + 1;
+
+	for (unsigned i = 1; i < 12; i++)
+	{
+		FaultRange *fr = domain->arena().make<FaultRange>(*fr0);
+		fr->m_pDRAM = chips[i];
+		if (i % 2)
+			chips[i]->put<Bits>(fr->fWildMask, 0);
+
+		error.intersection(FaultIntersection(fr, 0));
+		wrong_bits += __builtin_popcount(fr->fWildMask & 3) + 1;
+	}
+
+	FaultIntersection copy = error;
+	BOOST_CHECK( copy.chip_count() == 12 );
+	BOOST_CHECK( copy.bit_count_sum(3) == wrong_bits );
+
+	domain->reset();
+}
+
+/** The failures of a repair, at the symbol size of its first scheme, by intersection, number of chips and transience */
+std::vector<std::tuple<uint64_t, uint64_t, size_t, bool>> failure_list()
+{
+	domain->repair();
+
+	std::vector<std::tuple<uint64_t, uint64_t, size_t, bool>> list;
+	for (FaultIntersection *f: domain->intersecting_ranges(symbol_size))
+		list.emplace_back(f->fAddr, f->fWildMask, f->chip_count(), f->transient);
+	return list;
+}
+
+/** The failures of a repair of the same faults inserted into a reset domain, so enumerated anew */
+std::vector<std::tuple<uint64_t, uint64_t, size_t, bool>> fresh_failure_list()
+{
+	std::vector<std::vector<FaultRange>> faults;
+	for (DRAMDomain *chip: chips)
+	{
+		faults.emplace_back();
+		for (FaultRange *fr: chip->getRanges())
+			faults.back().push_back(*fr);
+	}
+
+	domain->reset();
+	for (size_t chip = 0; chip < chips.size(); chip++)
+		for (FaultRange &fr: faults[chip])
+			chips[chip]->insertFault(new FaultRange(fr));
+
+	return failure_list();
+}
+
+BOOST_AUTO_TEST_CASE( noECC_DRAM_updated_intersections )
+{
+	domain->reset();
+
+	// A word fault, bit faults in that word, one of them transient, and a word fault in another bank
+	FaultRange *word = chips[3]->genRandomRange(DRAM_1WORD, false);
+	auto bit = [word] (unsigned chip, unsigned b, bool transient) {
+		FaultRange *fr = new FaultRange(*word);
+		fr->transient = transient;
+		chips[chip]->put<Bits>(fr->fAddr, b);
+		chips[chip]->put<Bits>(fr->fWildMask, 0);
+		return fr;
+	};
+	FaultRange *other = new FaultRange(*word);
+	diff<Banks>(word, other);
+
+	chips[3]->insertFault(word);
+	chips[6]->insertFault(bit(6, 0, false));
+	chips[6]->insertFault(other);
+	chips[9]->insertFault(bit(9, 2, true));
+
+	// any set of the faults in the word, and the other fault
+	BOOST_CHECK( failure_list().size() == (1 << 3) - 1 + 1 );
+
+	// Faults in the word in a chip before and a chip after the known ones are added to the cached sets
+	chips[1]->insertFault(bit(1, 1, false));
+	FaultRange *last = new FaultRange(*word);
+	last->transient = true;
+	chips[12]->insertFault(last);
+
+	auto updated = failure_list();
+	BOOST_CHECK( updated.size() == (1 << 5) - 1 + 1 );
+	BOOST_CHECK( updated == fresh_failure_list() );
+
+	// Scrubbing the transient bit fault drops its sets
+	chips[9]->scrub();
+
+	auto scrubbed = failure_list();
+	BOOST_CHECK( scrubbed.size() == (1 << 4) - 1 + 1 );
+	BOOST_CHECK( scrubbed == fresh_failure_list() );
+
+	domain->reset();
+}
+
+BOOST_AUTO_TEST_CASE( noECC_DRAM_72chips )
+{
+	// Groups of more than 64 chips do not track which chips hold faults, and always run their repairs
+	Settings wide_conf = settings();
+	wide_conf.chips_per_rank = 72;
+	std::unique_ptr<GroupDomain_dimm> wide {GroupDomain_dimm::genModule(wide_conf, 0)};
+	std::vector<DRAMDomain *> wide_chips = get_chips(*wide);
+
+	FaultRange *fr0 = wide_chips[70]->genRandomRange(DRAM_1BIT, true);
+	FaultRange *fr1 = new FaultRange(*fr0);
+	wide_chips[70]->insertFault(fr0);
+	wide_chips[71]->insertFault(fr1);
+
+	BOOST_CHECK( wide->occupancy().empty() );
+	BOOST_CHECK( wide->danger_level() == 2 );
+	BOOST_CHECK( wide->repair().any() == true );
+
+	wide->reset();
+}
+
 };
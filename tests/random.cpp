@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <vector>
+#include <cmath>
+
+#include "RandomStream.hh"
+#include "AliasTable.hh"
+
+namespace random_stream
+{
+
+BOOST_AUTO_TEST_CASE( Random_philox_known_answers )
+{
+	// Known-answer tests from the Random123 distribution
+	RandomStream::counter_t zero = RandomStream::philox({0, 0, 0, 0}, {0, 0});
+	BOOST_CHECK( (zero == RandomStream::counter_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}) );
+
+	RandomStream::counter_t ones = RandomStream::philox({~0U, ~0U, ~0U, ~0U}, {~0U, ~0U});
+	BOOST_CHECK( (ones == RandomStream::counter_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}) );
+
+	RandomStream::counter_t pi = RandomStream::philox({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+	BOOST_CHECK( (pi == RandomStream::counter_t{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}) );
+}
+
+BOOST_AUTO_TEST_CASE( Random_streams_reproducible )
+{
+	RandomStream a(3, RandomStream::FAULT_TIMES), b(3, RandomStream::FAULT_TIMES);
+
+	// Consuming another simulation's stream first must not change the numbers of simulation 7
+	b.seed(42, 6);
+	for (int i = 0; i < 5; i++)
+		b();
+
+	a.seed(42, 7);
+	b.seed(42, 7);
+	for (int i = 0; i < 100; i++)
+		BOOST_CHECK( a() == b() );
+}
+
+BOOST_AUTO_TEST_CASE( Random_stream_at )
+{
+	RandomStream a(2, RandomStream::PROTECTED_ROWS), b(2, RandomStream::PROTECTED_ROWS);
+	a.seed(42, 7);
+	b.seed(42, 7);
+
+	// at(i) is the first number of the i-th block of the stream, and does not draw from it
+	RandomStream::result_type third_block = a.at(2);
+	for (int i = 0; i < 4; i++)
+		b();
+
+	BOOST_CHECK( b() == third_block );
+	BOOST_CHECK( a.at(2) == third_block );
+	BOOST_CHECK( a() == b.at(0) );
+}
+
+BOOST_AUTO_TEST_CASE( Random_streams_distinct )
+{
+	RandomStream streams[] = {
+		RandomStream(0, RandomStream::FAULT_TIMES), RandomStream(1, RandomStream::FAULT_TIMES),
+		RandomStream(0, RandomStream::FAULT_LOCATIONS), RandomStream(0, RandomStream::FAULT_TIMES),
+		RandomStream(0, RandomStream::FAULT_TIMES)
+	};
+
+	streams[0].seed(42, 0);
+	streams[1].seed(42, 0);
+	streams[2].seed(42, 0);
+	streams[3].seed(42, 1);
+	streams[4].seed(43, 0);
+
+	std::set<RandomStream::result_type> first_draws;
+	for (auto &stream: streams)
+		first_draws.insert(stream());
+
+	BOOST_CHECK( first_draws.size() == 5 );
+}
+
+BOOST_AUTO_TEST_CASE( Random_alias_table_frequencies )
+{
+	const std::vector<double> weights = {1., 0., 3., 6., .5, 2.};
+	const double total = 12.5;
+	const unsigned n_draws = 1000000;
+
+	AliasTable table(weights);
+	BOOST_REQUIRE( table.size() == weights.size() );
+
+	RandomStream gen(0, RandomStream::FAULT_TIMES);
+	gen.seed(42, 0);
+
+	std::vector<unsigned> draws(weights.size(), 0);
+	for (unsigned i = 0; i < n_draws; i++)
+		draws[table(gen)]++;
+
+	// Each frequency within 5 standard deviations of its probability
+	for (size_t i = 0; i < weights.size(); i++)
+	{
+		const double p = weights[i] / total;
+		BOOST_CHECK_MESSAGE( std::abs(draws[i] - p * n_draws) <= 5 * std::sqrt(p * (1 - p) * n_draws),
+				"weight " << weights[i] << " drawn " << draws[i] << " times" );
+	}
+}
+
+};
@@ -0,0 +1,234 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "dram_common.hh"
+#include "Settings.hh"
+#include "Simulation.hh"
+#include "DRAMDomain.hh"
+#include "GroupDomain_dimm.hh"
+
+namespace simulation
+{
+
+Settings settings(double fit_factor)
+{
+	Settings settings {};
+
+	settings.organization = Settings::DIMM;
+
+	settings.chips_per_rank = 18;
+	settings.chip_bus_bits = 4;
+	settings.ranks = 1;
+	settings.banks = 8;
+	settings.rows = 16384;
+	settings.cols = 2048;
+	settings.data_block_bits = 512;
+
+	settings.repairmode = Settings::DDC;  // Data Device Correct
+	settings.correct = 1;
+	settings.detect = 2;
+
+	settings.faultmode = Settings::JAGUAR;
+	settings.fit_factor = fit_factor;
+	settings.scf_factor = 1.;
+	settings.tsv_fit = 0.;
+	settings.enable_tsv = false;
+	settings.enable_transient = true;
+	settings.enable_permanent = true;
+	settings.fit_transient = {14.2, 1.4, 1.4, 0.2, 0.8, 0.3, 0.9};
+	settings.fit_permanent = {18.6, 0.3, 5.6, 8.2, 10.0, 1.4, 2.8};
+
+	settings.sw_tol = {0., 0., 0., 0., 0., 0., 0.};
+
+	return settings;
+}
+
+// 5 years, with daily scrubbing and weekly output bins
+const uint64_t max_time = 5 * 365 * 24 * 3600ULL, scrub_time = 24 * 3600, bin_time = 7 * 24 * 3600;
+
+/** Total FIT of a chip at a fit factor of 1 */
+const double chip_fit = 19.2 + 46.9;
+
+
+/** A simulation of a ChipKill DIMM that records the simulations it runs, and exposes the state of its estimators */
+class TracedSimulation : public Simulation
+{
+public:
+	struct run_t
+	{
+		double weight;
+		unsigned split_level;
+		std::vector<fault_class_t> faults;
+	};
+
+	std::vector<run_t> runs;
+	GroupDomain *domain;
+
+	TracedSimulation(double fit_factor, decltype(Settings::estimator) estimator)
+		: Simulation(scrub_time, false, false, bin_time, 1)
+		, runs()
+	{
+		Settings conf = settings(fit_factor);
+		domain = GroupDomain_dimm::genModule(conf, 0);
+		addDomain(domain);
+		setEstimator(estimator);
+	}
+
+	/** Run n_sims simulations, without printing their results */
+	void simulate(uint64_t n_sims)
+	{
+		std::ofstream no_output;
+		std::stringstream summary;
+
+		std::streambuf *out = std::cout.rdbuf(summary.rdbuf());
+		Simulation::simulate(max_time, n_sims, 0, no_output);
+		std::cout.rdbuf(out);
+	}
+
+	void prepare()
+	{
+		prepare_fault_sources();
+		prepare_estimator(max_time);
+	}
+
+	double runOne(uint64_t max_s, int verbose, uint64_t bin_length, std::vector<fault_event_t> &q1, double weight,
+				  unsigned split_level, uint64_t split_path)
+	{
+		std::vector<fault_class_t> faults;
+		for (auto &event: q1)
+			faults.push_back(event.second->m_pDRAM->maskClass(event.second->fWildMask));
+
+		runs.push_back({weight, split_level, faults});
+		return Simulation::runOne(max_s, verbose, bin_length, q1, weight, split_level, split_path);
+	}
+
+	using Simulation::m_fault_threshold;
+	using Simulation::m_p_threshold;
+	using Simulation::m_p_below;
+	using Simulation::m_fault_rate;
+	using Simulation::m_original_fault_rate;
+	using Simulation::m_is_no_fault_ratio;
+	using Simulation::m_fault_sources;
+};
+
+
+BOOST_AUTO_TEST_CASE( Simulation_conditional_threshold_probability )
+{
+	// About 3 faults expected per simulation
+	TracedSimulation sim(60., Settings::CONDITIONAL);
+	sim.prepare();
+
+	const double mean = 18 * chip_fit * 60. / 3600e9 * max_time;
+	BOOST_CHECK_CLOSE( sim.m_fault_rate * max_time, mean, 1e-9 );
+
+	// ChipKill needs faults in 2 chips, and the number of faults is Poisson-distributed
+	BOOST_REQUIRE( sim.m_fault_threshold == 2 );
+	BOOST_CHECK_CLOSE( sim.m_p_threshold, 1. - std::exp(-mean) * (1. + mean), 1e-9 );
+	BOOST_CHECK_CLOSE( sim.m_p_below, std::exp(-mean) * mean, 1e-9 );
+}
+
+BOOST_AUTO_TEST_CASE( Simulation_conditional_runs_above_threshold )
+{
+	TracedSimulation sim(60., Settings::CONDITIONAL);
+	sim.simulate(200);
+
+	// Simulations below the threshold are not run, i.e. have weight 0: every run has enough faults and the tail's weight
+	BOOST_REQUIRE( sim.runs.size() == 200 );
+	for (auto &run: sim.runs)
+	{
+		BOOST_CHECK( run.faults.size() >= sim.m_fault_threshold );
+		BOOST_CHECK( run.weight == sim.m_p_threshold );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( Simulation_importance_likelihood_ratio )
+{
+	// 1-bit faults sampled 4 times more often than they happen
+	TracedSimulation sim(20., Settings::IMPORTANCE);
+	std::vector<double> bias(DRAM_MAX, 1.);
+	bias[DRAM_1BIT] = 4.;
+	sim.setImportanceBias(bias);
+	sim.prepare();
+
+	for (auto &source: sim.m_fault_sources)
+		BOOST_CHECK( source.likelihood_ratio == (source.fault == DRAM_1BIT ? 1. / 4. : 1.) );
+
+	const double bit_rate = 18 * (14.2 + 18.6) * 20. / 3600e9;
+	BOOST_CHECK_CLOSE( sim.m_original_fault_rate, 18 * chip_fit * 20. / 3600e9, 1e-9 );
+	BOOST_CHECK_CLOSE( sim.m_fault_rate, sim.m_original_fault_rate + 3. * bit_rate, 1e-9 );
+	BOOST_CHECK_CLOSE( sim.m_is_no_fault_ratio, std::exp(3. * bit_rate * max_time), 1e-9 );
+
+	// Each simulation is weighted by the ratio for its total rate, and 1/4 for each of its 1-bit faults
+	sim.simulate(200);
+	BOOST_REQUIRE( sim.runs.size() == 200 );
+
+	size_t n_bits = 0;
+	for (auto &run: sim.runs)
+	{
+		const auto bits = std::count(run.faults.begin(), run.faults.end(), DRAM_1BIT);
+		BOOST_CHECK_CLOSE( run.weight, sim.m_is_no_fault_ratio * std::pow(1. / 4., bits), 1e-9 );
+		n_bits += bits;
+	}
+	BOOST_CHECK( n_bits > 0 );
+}
+
+BOOST_AUTO_TEST_CASE( Simulation_split_clone_weights )
+{
+	// Simulations split 4 ways with faults in 1 chip, then with faults in 2 chips of a bank
+	TracedSimulation sim(60., Settings::SPLITTING);
+	sim.setSplitting({1, 2}, 4);
+	sim.simulate(100);
+
+	// Runs are recorded depth first: a run splits if the next one is a level deeper, and its clones are the runs one level
+	// deeper until the next run at its level or above.
+	size_t n_splits = 0;
+	for (size_t i = 0; i < sim.runs.size(); i++)
+	{
+		const unsigned level = sim.runs[i].split_level;
+		double clone_weights = 0.;
+		unsigned n_clones = 0;
+
+		for (size_t j = i + 1; j < sim.runs.size() && sim.runs[j].split_level > level; j++)
+			if (sim.runs[j].split_level == level + 1)
+			{
+				clone_weights += sim.runs[j].weight;
+				n_clones++;
+			}
+
+		if (n_clones == 0)
+			continue;
+
+		n_splits++;
+		BOOST_CHECK( n_clones == 4 );
+		BOOST_CHECK_CLOSE( clone_weights, sim.runs[i].weight, 1e-9 );
+	}
+
+	BOOST_CHECK( n_splits > 0 );
+}
+
+BOOST_AUTO_TEST_CASE( Simulation_split_counts_one_failed_sim )
+{
+	TracedSimulation sim(60., Settings::SPLITTING);
+	sim.setSplitting({1, 2}, 4);
+	sim.simulate(100);
+
+	// A simulation with faults fails once, however many of its clones do
+	uint64_t n_roots = 0, n_failed = 0;
+	for (auto &run: sim.runs)
+		if (run.split_level == 0)
+		{
+			n_roots++;
+			n_failed += !run.faults.empty();
+		}
+
+	BOOST_REQUIRE( n_roots == 100 );
+	BOOST_CHECK( sim.runs.size() > n_roots );
+	BOOST_CHECK( sim.domain->getFailedSimCount() == n_failed );
+}
+
+};